@@ -26,6 +26,8 @@ extern "C" {
 #include "libfl2k_433_export.h"
 #include "osmo-fl2k.h"
 #include "sinegen.h"
+#include "txsource.h"
+#include "verify.h"
 #include "redir_print.h"
 
 #define FL2K_433_DEFAULT_SAMPLE_RATE 85555554
@@ -34,6 +36,7 @@ extern "C" {
 #define FL2K_433_DEFAULT_DEV_IDX 0
 #define FL2K_433_DEFAULT_VERBOSITY 1
 #define FL2K_433_DEFAULT_INIT_TIME 200
+#define FL2K_433_DEFAULT_MSG_ALIGN 1 // queued messages follow each other without any gap
 
 #define MAX_PATHLEN 300
 
@@ -58,6 +61,11 @@ typedef enum {
 		uint32_t carrier2;			// secondary carrier frequency (FSK)
 		uint8_t verbose;			// debug level. 0 = silent
 		uint32_t inittime_ms;		// milliseconds to wait for fl2k to initialize before transmitting actual payload
+		uint32_t init_samples;		// same as inittime_ms, but in samples. Takes precedence if > 0
+		uint32_t msg_align;			// queued messages start at multiples of this many samples within a buffer (1..FL2K_BUF_LEN). Not valid in file mode
+		uint64_t cpu_affinity;		// bitmask of CPUs for the libosmo-fl2k callback thread and render threads. 0 = no restriction
+		int32_t rt_priority;		// > 0: SCHED_FIFO priority (Windows: time critical) for these threads. 0 = unchanged
+		uint8_t mem_lock;			// > 0: lock the tx buffer and the signals of queued messages into RAM while running
 	} fl2k433cfg, *pfl2k433cfg;
 
 	// Configuration of the FL2K chipset in terms if achievable sample rate
@@ -73,7 +81,8 @@ typedef enum {
 		MODULATION_TYPE_NONE = 0, // invalid modulation types (for internal use)
 		MODULATION_TYPE_OOK  = 1, // Non-null sample: Send primary carrier frequency. Null sample: Send nothing (0 MHz)
 		MODULATION_TYPE_FSK  = 2, // Non-null sample: Send primary carrier frequency. Null sample: Send secondary carrier frequency
-		MODULATION_TYPE_SINE = 3  // Output a continuous sine wave (for testing purposes)
+		MODULATION_TYPE_SINE = 3, // Output a continuous sine wave (for testing purposes)
+		MODULATION_TYPE_RAW  = 4  // Pre-rendered output samples (replayed file mode capture), passed through unmodified
 	} mod_type;
 
 	// Tx messages that can be queued in in the fl2k_433 instance
@@ -86,6 +95,8 @@ typedef enum {
 		TxMsg *next;
 	}TxMsg, *pTxMsg;
 
+	typedef struct _TxNode TxNode; // queued message (private)
+
 	typedef struct _fl2k_data_info_fm_t { // extended version of fl2k_data_info_t for file mode
 		fl2k_data_info_t di;
 		mod_type msg_mod;      // != MODULATION_TYPE_NONE if a message is contained
@@ -100,11 +111,27 @@ typedef struct _fl2k_433 {
 	fl2k_dev_t *dev;				// Handle to current device
 	volatile fl2k433_state opstate;	// signals active operation mode (TX or file mode)
 	volatile int cancel_filemode;	// signal to cancel file mode. Not valid in FL2K mode
-	unsigned long starttime;		// timestamp set at txstart for checking cfg->inittime_ms. Only valid in FL2K mode (not in file mode)
+	uint64_t warmup_left;			// remaining samples of the starting phase (cfg->init_samples / cfg->inittime_ms). Only valid in FL2K mode (not in file mode)
+	uint64_t gap_left;				// remaining samples of the pause after the last message
+
+	int sched_applied;				// > 0 once cfg->cpu_affinity / rt_priority were applied to the callback thread
+	volatile int mem_locked;		// > 0 while cfg->mem_lock is in effect. Messages get locked into RAM when they are queued
+	int ref_render;					// > 0: compose messages with the per-sample reference loop instead of the kernels (BenchSynthesis)
+
+									/* Live reconfiguration */
+	volatile int retune_pending;	// set by txreconfigure, cleared by fl2k_callback once the settings below were applied
+	uint32_t retune_samp_rate;
+	uint32_t retune_carrier1;
+	uint32_t retune_carrier2;
+	int retune_busy;				// > 0 while txreconfigure resamples the queued messages (queued messages are not freed meanwhile)
+	TxNode *retune_done;			// messages finished by fl2k_callback while retune_busy was set. Freed by txreconfigure
 
 									/* TX queue */
-	TxMsg    *txqueue;				// Queue (linked list) with TX messages that shall be sent (new ones are appended at the end)
+	TxNode   *txqueue;				// Queue (linked list) with TX messages that shall be sent (new ones are appended at the end)
+	TxNode   *txqueue_tail;			// last message in the queue
+	struct _TpoolMutex *txqueue_mtx;	// (tpool.h) guards txqueue/txqueue_tail (and the links of the queued messages)
 	uint32_t  txqueue_sent;			// Number of bytes of current object (first in queue) that have already been sent
+	TxNode   *txretired;			// RAW message that finished zero-copy in the last callback. Freed by the next one (r_buf pointed into it)
 
 									/* TX buffer */
 	char txbuf[FL2K_BUF_LEN];		// tx buffer. Filled and passed to libosmo-fl2k by fl2k_callback.
@@ -116,8 +143,17 @@ typedef struct _fl2k_433 {
 FL2K_433_API int			fl2k_433_init(fl2k_433_t **out_fl2k);		// Creates a new fl2k_433 instance
 FL2K_433_API int			fl2k_433_destroy(fl2k_433_t *fl2k);			// Frees the instance
 FL2K_433_API int			txstart(fl2k_433_t *fl2k);					// Starts transmission mode. Blocks until finished or got stopped
+FL2K_433_API int			txdaemon(fl2k_433_t *fl2k, const char *name);	// Like txstart, but also serves messages of client processes (see shmq.h)
 FL2K_433_API int			txstop_signal(fl2k_433_t *fl2k);			// Signals a stop request
+FL2K_433_API int			txreconfigure(fl2k_433_t *fl2k, uint32_t samp_rate, uint32_t carrier1, uint32_t carrier2); // Changes sample rate/carriers at the next buffer boundary while TX keeps running (not atomic on air, see ApplyRetune)
 FL2K_433_API int			QueueTxMsg(fl2k_433_t *fl2k, TxMsg *msg);	// Queues a message to be TXed
+FL2K_433_API int			QueueTxMsgEx(fl2k_433_t *fl2k, TxMsg *msg, uint32_t gap);	// Queues a message to be TXed, followed by a pause of gap samples (at msg->samp_rate). Not valid in file mode
+FL2K_433_API int			QueueTxMsgBatch(fl2k_433_t *fl2k, TxMsg *msgs, const uint32_t *gaps, uint32_t n);	// Queues an array of n messages to be TXed (all or none). gaps: pause after each one (may be NULL)
+FL2K_433_API int			QueueTxSource(fl2k_433_t *fl2k, TxSource *src);	// Queues a streaming source to be TXed. On success, the instance takes ownership of src
+FL2K_433_API int			QueueReplayFile(fl2k_433_t *fl2k, const char *path);	// Queues a file mode capture (.bin) to be replayed without copying
+FL2K_433_API int			RenderTxMsgs(fl2k_433_t *fl2k, TxMsg *msgs, uint32_t n, uint32_t nthreads);	// Renders n messages offline into cfg.out_dir (one file each) using nthreads threads (0 = all cores)
+FL2K_433_API int			VerifySynthesis(fl2k_433_t *fl2k, int mod, uint32_t rf_target, VerifyReport *rep);	// Renders a test signal with the configuration of fl2k and measures its accuracy and speed (see verify.h)
+FL2K_433_API int			BenchSynthesis(int mod, int verbose, BenchReport *rep);	// Measures the speed of the OOK, FSK or SINE kernel at 85.5 MS/s with fixed settings (see verify.h)
 FL2K_433_API int			getQueueLength(fl2k_433_t *fl2k);
 FL2K_433_API fl2k433_state	getState(fl2k_433_t *fl2k);
 
@@ -0,0 +1,51 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_REPLAY_H
+#define FL2K_433_REPLAY_H
+
+#include <stdint.h>
+
+#define REPLAY_READAHEAD (4 * 1024 * 1024) // bytes to prefetch ahead of the current playback position
+
+// Read-only memory mapping of a file mode capture (the pages must not be written)
+typedef struct _ReplayMap {
+	char *data;			// start of the mapped file contents
+	uint64_t len;		// file size in bytes (= samples)
+#ifdef _WIN32
+	void *file;			// HANDLE of the opened file
+	void *mapping;		// HANDLE of the file mapping object
+#else
+	int fd;
+#endif
+} ReplayMap;
+
+/* Map a capture file into memory
+ * \return 1 on success, 0 on failure
+ */
+int  ReplayMap_open(const char *path, ReplayMap **out);
+void ReplayMap_close(ReplayMap *map);
+
+/* Hint the OS to read the given range of the mapping ahead of its use
+ */
+void ReplayMap_prefetch(ReplayMap *map, uint64_t offset, uint64_t len);
+
+/* Extract the modulation type, sample rate and carriers from the name of a file mode capture
+ * (e.g. OOK_s85555554_c6183693_1.bin). Carrier2 is set to 0 for OOK captures
+ * \return 1 if the name could be parsed, 0 otherwise
+ */
+int  ReplayMap_parseName(const char *path, int *mod, uint32_t *samp_rate, uint32_t *carrier1, uint32_t *carrier2);
+
+#endif // FL2K_433_REPLAY_H
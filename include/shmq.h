@@ -0,0 +1,90 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_SHMQ_H
+#define FL2K_433_SHMQ_H
+
+#include <stdint.h>
+#include "libfl2k_433_export.h"
+
+/* Shared memory message ring between several client processes and one daemon owning the FL2K device.
+ * Clients reserve a slot, write their samples straight into it and commit it. The daemon consumes the
+ * slots in reservation order. Notification: futex on the shared doorbell word (Linux), named event (Windows).
+ * Note: a client that dies between Shmq_reserve and Shmq_commit stalls the ring.
+ */
+
+#define SHMQ_MAGIC 0x464C324B // "FL2K"
+#define SHMQ_VERSION 1
+#define SHMQ_DEFAULT_SLOTS 64
+#define SHMQ_DEFAULT_SLOT_LEN (1024 * 1024) // max. number of samples per message
+
+typedef struct _ShmqHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t n_slots;
+	uint32_t slot_len;			// payload capacity of each slot
+	uint32_t slot_size;			// distance between two slots (header + payload, cache line aligned)
+	volatile uint32_t head;		// next ticket to be reserved by a client (slot = ticket % n_slots)
+	volatile uint32_t tail;		// next ticket to be consumed by the daemon
+	volatile uint32_t doorbell;	// incremented on every commit (futex word)
+	volatile uint32_t waiting;	// > 0 while the daemon sleeps on the doorbell
+} ShmqHeader;
+
+typedef struct _ShmqSlot {
+	volatile uint32_t seq;		// ticket + 1 once the slot was committed
+	int32_t mod;				// modulation type (mod_type)
+	uint32_t samp_rate;			// sample rate of the payload
+	uint32_t len;				// number of payload samples
+	uint32_t gap;				// pause after the message (samples at samp_rate)
+} ShmqSlot;						// payload follows at SHMQ_SLOT_HDR_LEN
+
+#define SHMQ_SLOT_HDR_LEN 64
+
+typedef struct _Shmq {
+	ShmqHeader *hdr;
+	char *slots;				// start of the first slot
+	uint64_t size;				// size of the whole mapping
+	uint32_t n_slots;			// own copies of the ring geometry (clients can write the shared header)
+	uint32_t slot_len;
+	uint32_t slot_size;
+	uint32_t tail;				// daemon only: next ticket to be consumed (published as hdr->tail)
+	int owner;					// > 0 for the daemon (creator) side
+	char name[64];
+#ifdef _WIN32
+	void *mapping;				// HANDLE of the file mapping object
+	void *event;				// HANDLE of the doorbell event
+#else
+	int lock_fd;				// daemon only: descriptor of the shared memory object, flock()ed while the daemon lives
+#endif
+} Shmq;
+
+// daemon side: see shmq_daemon.h (private to the library)
+
+// client side
+FL2K_433_API Shmq *Shmq_connect(const char *name);
+FL2K_433_API void  Shmq_disconnect(Shmq *q);
+
+/* Reserve a slot for a message of len samples
+ * \param ticket receives the reservation to be passed to Shmq_commit
+ * \return payload area to write the samples to, NULL if the ring is full (try again later) or len is too large
+ */
+FL2K_433_API char *Shmq_reserve(Shmq *q, uint32_t len, uint32_t *ticket);
+
+/* Publish a reserved slot to the daemon
+ * \return 0 on success
+ */
+FL2K_433_API int   Shmq_commit(Shmq *q, uint32_t ticket, int mod, uint32_t samp_rate, uint32_t len, uint32_t gap);
+
+#endif // FL2K_433_SHMQ_H
@@ -0,0 +1,34 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_SHMQ_DAEMON_H
+#define FL2K_433_SHMQ_DAEMON_H
+
+// Daemon side of the shared memory ring (shmq.h). Private to the library (used by txdaemon, not exported)
+
+#include <stdint.h>
+#include "shmq.h"
+
+Shmq *Shmq_create(const char *name, uint32_t n_slots, uint32_t slot_len);	// fails if another daemon serves the ring
+void  Shmq_destroy(Shmq *q);
+/* Wait for the next committed slot
+ * \param slot receives a copy of the slot header (clients may still write to the shared one). Its len is not checked
+ * \param payload receives the payload area of the slot (q->slot_len bytes)
+ * \return 1 if the next slot is committed, 0 on timeout
+ */
+int   Shmq_next(Shmq *q, ShmqSlot *slot, char **payload, uint32_t timeout_ms);
+void  Shmq_release(Shmq *q);	// hands the slot returned by Shmq_next back to the clients
+
+#endif // FL2K_433_SHMQ_DAEMON_H
@@ -2,9 +2,12 @@
 	#define INCLUDE_SINEGEN_H
 
 	#define REFSINE_RESOLUTION 16384
+	#define REFSINE_QUARTER (REFSINE_RESOLUTION / 4)
+
+// process-wide, read-only quarter wave table (4 KB, fits into L1 cache). See sinetable.c
+extern const signed char sine_quarter[REFSINE_QUARTER + 1];
 
 typedef struct _SineGen {
-	char *sine_curve;
 	double sine_step;
 	unsigned long pos_startidx;
 	unsigned long pos_numsteps;
@@ -14,5 +17,15 @@ int  SineGen_init(SineGen **sg);
 void SineGen_destroy(SineGen *sg);
 void SineGen_configure(SineGen *sg, unsigned long samp_rate, unsigned long freq);
 char SineGen_getSample(SineGen *sg);
+void SineGen_fill(SineGen *sg, char *out, unsigned long n); // same as n calls of SineGen_getSample
+
+// Sample of the reference sine at position idx (modulo REFSINE_RESOLUTION)
+static __inline char SineGen_lookup(unsigned long long idx) {
+	unsigned int i = (unsigned int)(idx % REFSINE_RESOLUTION);
+	unsigned int q = i / REFSINE_QUARTER; // quadrant
+	unsigned int j = i % REFSINE_QUARTER;
+	char v = sine_quarter[(q & 1) ? REFSINE_QUARTER - j : j];
+	return ((q & 2) ? -v : v);
+}
 
 #endif // INCLUDE_SINEGEN_H
@@ -0,0 +1,28 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_STUBDEV_H
+#define FL2K_433_STUBDEV_H
+
+// Private to the library (not included by libfl2k_433.h, not exported)
+
+#include <stdint.h>
+#include "libfl2k_433.h"
+
+// Runs the callback once like libosmo-fl2k would (FL2K mode, without starting phase) and returns the buffer, NULL if
+// cfg.msg_align is out of range. *elapsed_us receives the time spent in the callback. Used by verify.c
+char *StubDevice_pull(fl2k_433_t *fl2k, uint64_t *elapsed_us);
+
+#endif // FL2K_433_STUBDEV_H
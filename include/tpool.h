@@ -0,0 +1,73 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_TPOOL_H
+#define FL2K_433_TPOOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TPOOL_MAX_THREADS 64
+
+typedef void(*TpoolWorkFn)(void *ctx, uint32_t idx);
+
+// Scheduling settings for threads run by the library
+typedef struct _TpoolSched {
+	uint64_t cpu_affinity;	// bitmask of allowed CPUs. 0 = no restriction
+	int32_t rt_priority;	// > 0: real-time priority (SCHED_FIFO, Windows: time critical). 0 = unchanged
+} TpoolSched;
+
+/* Number of online CPU cores (at least 1)
+ */
+uint32_t Tpool_numCores(void);
+
+/* Run fn(ctx, idx) for every idx in [0, n) on up to nthreads threads.
+ * Indices are handed out dynamically, so items of different sizes balance out.
+ * \param nthreads number of threads to use. 0 = one per CPU core
+ * \param sched scheduling settings for the worker threads. If NULL, the calling thread helps out,
+ *        otherwise it only waits (so its own scheduling stays untouched)
+ * \return number of threads that were actually used
+ */
+uint32_t Tpool_parallelFor(uint32_t n, uint32_t nthreads, TpoolWorkFn fn, void *ctx, const TpoolSched *sched);
+
+/* Apply scheduling settings to the calling thread. Failures are reported on stderr
+ * \param who name of the thread for the error messages
+ * \return 0 on success, number of settings that failed otherwise
+ */
+int Tpool_applySched(const TpoolSched *sched, const char *who);
+
+/* Lock the pages of the given range into RAM. Locks are not nested: unlocking a range also unlocks
+ * pages it shares with other locked ranges. Failures are reported on stderr
+ * \return 1 on success, 0 on failure
+ */
+int  Tpool_lockMemory(void *addr, size_t len);
+void Tpool_unlockMemory(void *addr, size_t len);
+
+typedef struct _TpoolThread TpoolThread;
+
+/* Run fn(ctx) on a new thread (with the given scheduling settings, may be NULL)
+ * \return thread handle for Tpool_threadJoin, NULL on failure
+ */
+TpoolThread *Tpool_threadStart(void(*fn)(void *ctx), void *ctx, const TpoolSched *sched);
+void Tpool_threadJoin(TpoolThread *thread);
+
+typedef struct _TpoolMutex TpoolMutex;
+
+TpoolMutex *Tpool_mutexCreate(void);
+void Tpool_mutexDestroy(TpoolMutex *mtx);
+void Tpool_mutexLock(TpoolMutex *mtx);
+void Tpool_mutexUnlock(TpoolMutex *mtx);
+
+#endif // FL2K_433_TPOOL_H
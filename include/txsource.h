@@ -0,0 +1,80 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_TXSOURCE_H
+#define FL2K_433_TXSOURCE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "libfl2k_433_export.h"
+
+#define TXSOURCE_CHUNK_LEN 65536 // number of input samples pulled from a source at once
+
+/* Pull function of a streaming source.
+ * \param ctx user specific context
+ * \param buf buffer to receive the next input samples (one byte per sample, != 0 = high)
+ * \param len capacity of buf
+ * \return number of samples written to buf. 0 signals the end of the stream
+ */
+typedef uint32_t(*TxSourceReadFn)(void *ctx, char *buf, uint32_t len);
+typedef void(*TxSourceCloseFn)(void *ctx);
+
+typedef struct _TxSource {
+	int mod;					// modulation type (mod_type, OOK or FSK)
+	uint32_t samp_rate;			// sample rate of the input samples
+	TxSourceReadFn read;		// pull function
+	TxSourceCloseFn close;		// optional, called on destruction
+	void *ctx;					// user specific context passed to read/close
+
+	// private: resampling state
+	char *chunk;				// last chunk pulled from the source
+	uint32_t chunk_len;			// number of valid samples in chunk
+	uint64_t chunk_base;		// absolute input index of chunk[0]
+	uint64_t in_idx;			// absolute input index of the next output sample
+	uint64_t in_frac;			// fractional part of in_idx (in units of 1/out_rate)
+	int eof;					// > 0 if the source reported its end
+} TxSource;
+
+/* Create a source reading raw input samples from a file on disk
+ * \param path file to read from
+ * \param mod modulation type (OOK or FSK)
+ * \param samp_rate sample rate of the file contents
+ * \return new source object or NULL on failure
+ */
+FL2K_433_API TxSource *TxSource_openFile(const char *path, int mod, uint32_t samp_rate);
+
+/* Create a source pulling its input samples from a generator function
+ * \param gen generator function, returns 0 if there are no more samples
+ * \param close optional cleanup function for ctx (may be NULL)
+ * \param ctx user specific context passed to gen/close
+ * \param mod modulation type (OOK or FSK)
+ * \param samp_rate sample rate of the generated samples
+ * \return new source object or NULL on failure
+ */
+FL2K_433_API TxSource *TxSource_openGenerator(TxSourceReadFn gen, TxSourceCloseFn close, void *ctx, int mod, uint32_t samp_rate);
+
+/* Destroy a source. Sources passed to QueueTxSource are owned (and destroyed) by the library
+ */
+FL2K_433_API void TxSource_destroy(TxSource *src);
+
+/* Pull samples from a source and resample them to the output rate
+ * \param out output buffer
+ * \param out_len capacity of out
+ * \param out_rate target sample rate
+ * \return number of samples written to out. Less than out_len only at the end of the stream
+ */
+uint32_t TxSource_render(TxSource *src, char *out, uint32_t out_len, uint32_t out_rate);
+
+#endif // FL2K_433_TXSOURCE_H
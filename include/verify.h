@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef FL2K_433_VERIFY_H
+#define FL2K_433_VERIFY_H
+
+#include <stdint.h>
+
+// Test signal used by VerifySynthesis
+#define VERIFY_IN_RATE 1000000		// sample rate of the OOK/FSK test message
+#define VERIFY_SYMBOL_LEN 100		// input samples per symbol (10 kBd)
+#define VERIFY_NUM_SYMBOLS 254		// symbols of the test message (PRBS7, two periods)
+#define VERIFY_SINE_BUFS 4			// FL2K buffers rendered for SINE
+
+// Spectral analysis (SINE)
+#define VERIFY_FFT_LEN 262144		// samples analysed for spurs (power of 2)
+#define VERIFY_SPUR_SPAN 2000000	// spurs are searched within +- this many Hz around the carrier
+#define VERIFY_SPUR_GUARD 16		// FFT bins next to the carrier that belong to its main lobe
+
+// Result of VerifySynthesis. Values that don't apply to the tested modulation type are 0
+typedef struct _VerifyReport {
+	int mod;					// tested modulation type (mod_type)
+	uint64_t n_samples;			// number of output samples rendered
+	double samples_per_sec;		// speed of the callback (resampling at queueing time excluded)
+	double carrier1_err;		// measured minus configured frequency of the primary carrier (Hz)
+	double carrier2_err;		// same for the secondary carrier (FSK with carrier2 > 0)
+	uint32_t n_edges;			// number of symbol edges checked (OOK/FSK)
+	double edge_jump;			// largest sample step at a symbol edge relative to the largest step within the carrier (<= ~1: no glitch)
+	double phase_err;			// largest phase discontinuity at a symbol edge (rad, FSK with carrier2 > 0)
+	double timing_err_mean;		// mean deviation of the symbol edges from their position in the input TxMsg (us, signed)
+	double timing_err_max;		// largest absolute deviation (us)
+	double spur_dbc;			// strongest spur within +-VERIFY_SPUR_SPAN around the carrier, relative to the carrier (dB, SINE)
+	double spur_offset;			// its distance from the carrier (Hz)
+	double rf_image;			// image of the primary carrier (k * samp_rate +- carrier1) closest to the RF target (Hz)
+} VerifyReport;
+
+// Kernel benchmark (BenchSynthesis). Fixed settings, so results can be compared between builds and machines
+#define BENCH_SAMP_RATE 85555554	// 85.5 MS/s
+#define BENCH_CARRIER1 6183693		// primary carrier (OOK, FSK, SINE)
+#define BENCH_CARRIER2 7000000		// secondary carrier (FSK)
+#define BENCH_BUFS 64				// FL2K buffers rendered per run (~1 s of signal)
+#define BENCH_RUNS 5				// runs per kernel (and per reference), the fastest one is reported
+
+// Result of BenchSynthesis
+typedef struct _BenchReport {
+	int mod;					// benchmarked modulation type (mod_type)
+	uint64_t n_samples;			// output samples rendered per run
+	double samples_per_sec;		// speed of the fastest run (callback only, resampling at queueing time excluded)
+	double samples_per_sec_mean;	// mean speed of all runs
+	double ref_samples_per_sec;	// same for the per-sample reference loop the kernels replaced (fastest run)
+	double ref_samples_per_sec_mean;
+	double speedup;				// samples_per_sec / ref_samples_per_sec
+	double realtime;			// samples_per_sec / BENCH_SAMP_RATE (>= 1: the kernel keeps up with the device)
+} BenchReport;
+
+#endif // FL2K_433_VERIFY_H
@@ -23,10 +23,12 @@
 #ifndef _WIN32
 #include <unistd.h>
 #define sleep_ms(ms)	usleep(ms*1000)
+#define fseek64(f, off, org)	fseeko(f, (off_t)(off), org)
 #else
 #include <windows.h>
 #include <io.h>
 #define sleep_ms(ms)	Sleep(ms)
+#define fseek64(f, off, org)	_fseeki64(f, off, org)
 #ifdef _MSC_VER
 #define F_OK 0
 #endif
@@ -34,15 +36,48 @@
 
 #include "libfl2k_433.h"
 #include "redir_print.h"
+#include "tpool.h"
+#include "shmq_daemon.h"
+#include "replay.h"
+#include "stubdev.h"
 
 #define FILEMODE_SLEEP_TIME 50
+#define DAEMON_POLL_TIME 100 // ms to wait for client messages before checking for a stop request
+#define DAEMON_MAX_MSG_MS 2000 // longest client message accepted by txdaemon (bounds the resampled size: ~171 MB at 85.5 MS/s)
+#define DAEMON_MAX_GAP_MS 10000 // longest pause after a client message accepted by txdaemon
+#define FL2K_433_BATCH_PARALLEL_MIN (8 * FL2K_BUF_LEN) // minimum number of output samples in a batch to resample it in parallel
+
+// Queue entry (private): resampled message plus what's needed to send it
+struct _TxNode {
+	mod_type mod;
+	char *buf;
+	uint32_t len;
+	uint32_t samp_rate;
+	uint32_t gap;	// pause (0 MHz) to insert after this message, in samples at samp_rate. Not valid in file mode
+	TxSource *src;	// streaming source. If set, buf is refilled from it one FL2K buffer at a time
+	ReplayMap *map;	// memory mapped capture. If set, buf points into the mapping
+	char *in_buf;	// copy of the input signal (OOK/FSK), resampled again by txreconfigure if the sample rate changes
+	uint32_t in_len;
+	uint32_t in_rate;
+	uint32_t in_gap;	// gap in samples at in_rate
+	char *next_buf;	// signal prepared by txreconfigure for next_rate, swapped in by the callback. Holds the replaced signal afterwards
+	uint32_t next_len;
+	uint32_t next_rate;	// 0 if next_buf holds no prepared signal
+	uint32_t next_gap;
+	uint32_t lock_len;	// bytes of buf locked into RAM (cfg->mem_lock), 0 if not locked
+	uint32_t next_lock_len;	// same for next_buf
+	TxNode *next;
+};
 
 // forward declaration of private methods (not in header)
 static void		fl2k_callback(fl2k_data_info_t *data_info);	// Callback function for libosmo-fl2k
 static int		InitFl2k(fl2k_433_t *fl2k);				// Initializes the FL2K device using libosmo-fl2k
 static void		loadDefaultConfig(fl2k_433_t *fl2k);	// Loads the default configuration
-static TxMsg*	TxPop(fl2k_433_t *fl2k);
-static void		TxPush(fl2k_433_t *fl2k, TxMsg *msg);
+static TxNode*	TxPop(fl2k_433_t *fl2k);
+static TxNode*	TxPeek(fl2k_433_t *fl2k);
+static void		TxPush(fl2k_433_t *fl2k, TxNode *msg);
+static void		TxFree(TxNode *msg);
+static void		TxRelease(fl2k_433_t *fl2k, TxNode *msg);
 static FILE*	openOutputFile(char *dir, mod_type mod, uint32_t samp_rate, uint32_t carrier1, uint32_t carrier2, uint32_t *filenum);
 static void*	file_mode(fl2k_433_t *fl2k);
 
@@ -54,6 +89,12 @@ FL2K_433_API int	fl2k_433_init(fl2k_433_t **out_fl2k) {
 
 	fl2k_433_t *fl2k = (fl2k_433_t*)calloc(1, sizeof(fl2k_433_t));
 	if (fl2k) {
+		fl2k->txqueue_mtx = Tpool_mutexCreate();
+		if (!fl2k->txqueue_mtx) {
+			free(fl2k);
+			*out_fl2k = NULL;
+			return FL2K_433_ERROR_OUTOFMEM;
+		}
 		fl2k->opstate = FL2K433_STOPPED;
 		loadDefaultConfig(fl2k);
 		SineGen_init(&fl2k->sg);
@@ -71,15 +112,21 @@ FL2K_433_API int fl2k_433_destroy(fl2k_433_t *fl2k) {
 	}
 
 	// free queue
-	TxMsg *m = TxPop(fl2k);
+	TxNode *m = TxPop(fl2k);
 	while (m != NULL) {
-		if (m->buf) free(m->buf);
-		free(m);
+		TxFree(m);
 		m = TxPop(fl2k);
 	}
 
+	if (fl2k->txretired) TxFree(fl2k->txretired);
+	while ((m = fl2k->retune_done) != NULL) {
+		fl2k->retune_done = m->next;
+		TxFree(m);
+	}
+
 	// destroy sine generator
 	if (fl2k->sg) SineGen_destroy(fl2k->sg);
+	Tpool_mutexDestroy(fl2k->txqueue_mtx);
 
 	// free object
 	free(fl2k);
@@ -98,141 +145,536 @@ static void loadDefaultConfig(fl2k_433_t *fl2k) {
 	fl2k->cfg.verbose = FL2K_433_DEFAULT_VERBOSITY;
 	memset(fl2k->cfg.out_dir, 0, sizeof(fl2k->cfg.out_dir));
 	fl2k->cfg.inittime_ms = FL2K_433_DEFAULT_INIT_TIME;
+	fl2k->cfg.init_samples = 0;
+	fl2k->cfg.msg_align = FL2K_433_DEFAULT_MSG_ALIGN;
+	fl2k->cfg.cpu_affinity = 0;
+	fl2k->cfg.rt_priority = 0;
+	fl2k->cfg.mem_lock = 0;
 }
 
-static TxMsg *TxPop(fl2k_433_t *fl2k) {
-	TxMsg *msg = fl2k->txqueue;
+// The queue links are guarded by txqueue_mtx: messages are appended by API calls (and the daemon worker) while the
+// callback thread takes them from the head. Only the callback removes messages, so it may use the head without the lock.
+// The mutex also guards the reconfiguration state (retune_busy, retune_done, retune_samp_rate, cfg.samp_rate while running)
+static TxNode *TxPop(fl2k_433_t *fl2k) {
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	TxNode *msg = fl2k->txqueue;
 	if (msg) {
 		fl2k->txqueue = msg->next;
+		if (!fl2k->txqueue) fl2k->txqueue_tail = NULL;
 		fl2k->txqueue_sent = 0;
 		msg->next = NULL;
 	}
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
 	return msg;
 }
 
-static void TxPush(fl2k_433_t *fl2k, TxMsg *msg) {
-	TxMsg **ptr = &fl2k->txqueue;
-	while (*ptr) ptr = &(*ptr)->next;
-	*ptr = msg;
+static TxNode *TxPeek(fl2k_433_t *fl2k) {
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	TxNode *msg = fl2k->txqueue;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	return msg;
 }
 
-// important: target sample rate must have already been set when queuing a TX message
-FL2K_433_API int QueueTxMsg(fl2k_433_t *fl2k, TxMsg *msg_in) {
-	int r = -1;
-	if (!msg_in || (msg_in->mod != MODULATION_TYPE_SINE && (!msg_in->buf || msg_in->len < 1 || msg_in->next))) {
-		fl2k433_fprintf(stderr, "QueueTxMsg: Malformed TX message object can not be queued\n");
-		return r;
+// Appends msg (may be a chain of messages)
+static void TxPush(fl2k_433_t *fl2k, TxNode *msg) {
+	TxNode *last = msg;
+	while (last->next) last = last->next;
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	if (fl2k->txqueue_tail) fl2k->txqueue_tail->next = msg;
+	else fl2k->txqueue = msg;
+	fl2k->txqueue_tail = last;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+}
+
+// During a reconfiguration new messages are resampled to the upcoming rate right away
+static uint32_t TxQueueRateLocked(fl2k_433_t *fl2k) {
+	return ((fl2k->retune_busy || fl2k->retune_pending) ? fl2k->retune_samp_rate : fl2k->cfg.samp_rate);
+}
+
+// Same as TxPush, but only if OOK/FSK messages resampled to samp_rate are still wanted (a reconfiguration may have
+// started meanwhile). Returns 0 if not, the caller has to resample again at TxQueueRate
+static int TxPushAt(fl2k_433_t *fl2k, TxNode *msg, uint32_t samp_rate) {
+	TxNode *last = msg;
+	while (last->next) last = last->next;
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	int r = (TxQueueRateLocked(fl2k) == samp_rate);
+	if (r) {
+		if (fl2k->txqueue_tail) fl2k->txqueue_tail->next = msg;
+		else fl2k->txqueue = msg;
+		fl2k->txqueue_tail = last;
 	}
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	return r;
+}
+
+// Sample rate new OOK/FSK messages have to be resampled to
+static uint32_t TxQueueRate(fl2k_433_t *fl2k) {
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	uint32_t samp_rate = TxQueueRateLocked(fl2k);
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	return samp_rate;
+}
 
-	if (msg_in->mod == MODULATION_TYPE_SINE) {
-		TxMsg *msg_out = calloc(1, sizeof(TxMsg));
-		msg_out->mod = msg_in->mod;
-		TxPush(fl2k, msg_out);
-		r = 0;
+// cfg->mem_lock: locks the signal of a message into RAM before it gets queued (captures are paged in from their file)
+static void TxLock(fl2k_433_t *fl2k, TxNode *msg) {
+	if (!fl2k->mem_locked || msg->map || !msg->buf || msg->lock_len) return;
+	uint32_t len = (msg->src ? FL2K_BUF_LEN : msg->len);
+	if (Tpool_lockMemory(msg->buf, len)) msg->lock_len = len;
+}
+
+static void TxFreeBuf(char *buf, uint32_t lock_len) {
+	if (lock_len) Tpool_unlockMemory(buf, lock_len);
+	free(buf);
+}
+
+static void TxFree(TxNode *msg) {
+	if (msg->map) ReplayMap_close(msg->map); // buf points into the mapping
+	else if (msg->buf) TxFreeBuf(msg->buf, msg->lock_len);
+	if (msg->src) TxSource_destroy(msg->src);
+	if (msg->in_buf) free(msg->in_buf);
+	if (msg->next_buf) TxFreeBuf(msg->next_buf, msg->next_lock_len);
+	free(msg);
+}
+
+// Frees a message taken off the queue. While txreconfigure works on the queued messages it is handed over instead
+static void TxRelease(fl2k_433_t *fl2k, TxNode *msg) {
+	if (!msg) return;
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	if (fl2k->retune_busy) {
+		msg->next = fl2k->retune_done;
+		fl2k->retune_done = msg;
+		msg = NULL;
 	}
-	else if (msg_in->mod == MODULATION_TYPE_OOK || msg_in->mod == MODULATION_TYPE_FSK) {
-		TxMsg *msg_out = calloc(1, sizeof(TxMsg));
-		msg_out->mod = msg_in->mod;
-		msg_out->samp_rate = fl2k->cfg.samp_rate;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	if (msg) TxFree(msg);
+}
+
+// Scheduling settings for the threads run by the library (render threads, libosmo-fl2k callback thread).
+// Returns NULL if none are configured, so Tpool_parallelFor lets the calling thread help out
+static const TpoolSched *SchedCfg(fl2k_433_t *fl2k, TpoolSched *sched) {
+	if (!fl2k->cfg.cpu_affinity && !fl2k->cfg.rt_priority) return NULL;
+	sched->cpu_affinity = fl2k->cfg.cpu_affinity;
+	sched->rt_priority = fl2k->cfg.rt_priority;
+	return sched;
+}
+
+static int TxMsgValid(TxMsg *msg) {
+	return (msg && (msg->mod == MODULATION_TYPE_SINE || (msg->buf && msg->len >= 1 && msg->samp_rate > 0 && !msg->next)));
+}
+
+// Allocates the queue object for an input message, including the buffer for the resampled signal.
+// gap: pause after the message, in samples at the rate of the input message
+// keep_input: also keep a copy of the input signal (queued messages, see txreconfigure)
+static TxNode *TxAlloc(TxMsg *msg_in, uint32_t gap, uint32_t samp_rate, int keep_input) {
+	TxNode *msg_out = calloc(1, sizeof(TxNode));
+	if (!msg_out) return NULL;
+	msg_out->mod = msg_in->mod;
+	if (msg_in->mod == MODULATION_TYPE_OOK || msg_in->mod == MODULATION_TYPE_FSK) {
+		msg_out->samp_rate = samp_rate;
 		double scale_factor = (double)msg_out->samp_rate / (double)msg_in->samp_rate;
-		msg_out->len = (int)((double)msg_in->len * scale_factor);
+		if ((double)msg_in->len * scale_factor >= (double)UINT32_MAX) { // too long after resampling
+			free(msg_out);
+			return NULL;
+		}
+		msg_out->len = (uint32_t)((double)msg_in->len * scale_factor);
+		msg_out->gap = (uint32_t)((double)gap * scale_factor);
 		msg_out->buf = (char*)malloc(msg_out->len);
-		uint32_t trgidx1 = 0; // will carry a * scale_factor
-		for (uint32_t a = 0; a < (msg_in->len - 1); a++) {
-			uint32_t trgidx2 = (int)((double)(a + 1) * scale_factor);
-			uint32_t trgidxm = trgidx1 + ((trgidx2 - trgidx1) / 2);
-			uint32_t t1safe = min(trgidx1, msg_out->len - 1);
-			uint32_t t2safe = min(trgidx2, msg_out->len - 1);
-			uint32_t tmsafe = min(trgidxm, msg_out->len - 1);
-			for (uint32_t b = t1safe; b < tmsafe; b++) {
-				msg_out->buf[b] = msg_in->buf[a];
-			}
-			for (uint32_t b = tmsafe; b < t2safe; b++) {
-				msg_out->buf[b] = msg_in->buf[a + 1];
+		if (!msg_out->buf) {
+			free(msg_out);
+			return NULL;
+		}
+		if (keep_input) {
+			msg_out->in_buf = (char*)malloc(msg_in->len);
+			if (!msg_out->in_buf) {
+				TxFree(msg_out);
+				return NULL;
 			}
-			trgidx1 = trgidx2;
+			memcpy(msg_out->in_buf, msg_in->buf, msg_in->len);
+			msg_out->in_len = msg_in->len;
+			msg_out->in_rate = msg_in->samp_rate;
+			msg_out->in_gap = gap;
 		}
-		for (uint32_t a = trgidx1; a < msg_out->len; a++) {
-			msg_out->buf[a] = msg_in->buf[msg_in->len - 1];
+	}
+	return msg_out;
+}
+
+// Resamples the signal in (in_len samples at in_rate) into out (out_len samples at out_rate)
+static void TxResampleBuf(const char *in, uint32_t in_len, uint32_t in_rate, char *out, uint32_t out_len, uint32_t out_rate) {
+	double scale_factor = (double)out_rate / (double)in_rate;
+	uint32_t trgidx1 = 0; // will carry a * scale_factor
+	for (uint32_t a = 0; a < (in_len - 1); a++) {
+		uint32_t trgidx2 = (int)((double)(a + 1) * scale_factor);
+		uint32_t trgidxm = trgidx1 + ((trgidx2 - trgidx1) / 2);
+		uint32_t t1safe = min(trgidx1, out_len - 1);
+		uint32_t t2safe = min(trgidx2, out_len - 1);
+		uint32_t tmsafe = min(trgidxm, out_len - 1);
+		for (uint32_t b = t1safe; b < tmsafe; b++) {
+			out[b] = in[a];
+		}
+		for (uint32_t b = tmsafe; b < t2safe; b++) {
+			out[b] = in[a + 1];
 		}
-		TxPush(fl2k, msg_out);
-		r = 0;
+		trgidx1 = trgidx2;
 	}
-	else {
+	for (uint32_t a = trgidx1; a < out_len; a++) {
+		out[a] = in[in_len - 1];
+	}
+}
+
+// Resamples the signal of msg_in into the (already allocated) buffer of msg_out
+static void TxResample(TxMsg *msg_in, TxNode *msg_out) {
+	if (msg_out->mod != MODULATION_TYPE_OOK && msg_out->mod != MODULATION_TYPE_FSK) return;
+	TxResampleBuf(msg_in->buf, msg_in->len, msg_in->samp_rate, msg_out->buf, msg_out->len, msg_out->samp_rate);
+}
+
+// Resamples a queued OOK/FSK message from its original input to samp_rate, into next_buf. Called by txreconfigure
+// (not by the callback), the callback swaps the prepared signal in once the new rate is applied (TxSwapPrepared)
+static int TxPrepare(TxNode *msg, uint32_t samp_rate) {
+	msg->next_rate = 0;
+	if (!msg->in_buf || msg->samp_rate == samp_rate) return 1; // nothing to prepare
+	double scale_factor = (double)samp_rate / (double)msg->in_rate;
+	if ((double)msg->in_len * scale_factor >= (double)UINT32_MAX) return 0;
+	if (msg->next_buf) TxFreeBuf(msg->next_buf, msg->next_lock_len);
+	msg->next_lock_len = 0;
+	msg->next_len = (uint32_t)((double)msg->in_len * scale_factor);
+	msg->next_buf = (char*)malloc(msg->next_len);
+	if (!msg->next_buf) return 0;
+	TxResampleBuf(msg->in_buf, msg->in_len, msg->in_rate, msg->next_buf, msg->next_len, samp_rate);
+	if (msg->lock_len && Tpool_lockMemory(msg->next_buf, msg->next_len)) msg->next_lock_len = msg->next_len;
+	msg->next_gap = (uint32_t)((double)msg->in_gap * scale_factor);
+	msg->next_rate = samp_rate;
+	return 1;
+}
+
+// Swaps in the signals prepared for samp_rate. Runs in the callback with txqueue_mtx held, pointer swaps only
+static void TxSwapPrepared(fl2k_433_t *fl2k, uint32_t samp_rate) {
+	for (TxNode *msg = fl2k->txqueue; msg; msg = msg->next) {
+		if (msg->next_rate != samp_rate || msg->samp_rate == samp_rate) continue;
+		if (msg == fl2k->txqueue) fl2k->txqueue_sent = min((uint32_t)((double)fl2k->txqueue_sent * samp_rate / msg->samp_rate), msg->next_len);
+		char *buf = msg->buf;
+		uint32_t len = msg->len, lock_len = msg->lock_len;
+		msg->buf = msg->next_buf;
+		msg->len = msg->next_len;
+		msg->lock_len = msg->next_lock_len;
+		msg->gap = msg->next_gap;
+		msg->samp_rate = samp_rate;
+		msg->next_buf = buf; // freed with the message (or replaced by the next reconfiguration)
+		msg->next_len = len;
+		msg->next_lock_len = lock_len;
+		msg->next_rate = 0;
+	}
+}
+
+// important: target sample rate must have already been set when queuing a TX message
+FL2K_433_API int QueueTxMsg(fl2k_433_t *fl2k, TxMsg *msg_in) {
+	return QueueTxMsgEx(fl2k, msg_in, 0);
+}
+
+// Same as QueueTxMsg, followed by a pause of gap samples (at msg_in->samp_rate) before the next message starts
+FL2K_433_API int QueueTxMsgEx(fl2k_433_t *fl2k, TxMsg *msg_in, uint32_t gap) {
+	if (!TxMsgValid(msg_in)) {
+		fl2k433_fprintf(stderr, "QueueTxMsg: Malformed TX message object can not be queued\n");
+		return -1;
+	}
+	if (msg_in->mod != MODULATION_TYPE_SINE && msg_in->mod != MODULATION_TYPE_OOK && msg_in->mod != MODULATION_TYPE_FSK) {
 		fl2k433_fprintf(stderr, "QueueTxMsg: TX message can not be queued due to unknown modulation type\n");
+		return -1;
 	}
-	return r;
+
+	for (;;) {
+		uint32_t samp_rate = TxQueueRate(fl2k);
+		TxNode *msg_out = TxAlloc(msg_in, gap, samp_rate, 1);
+		if (!msg_out) {
+			fl2k433_fprintf(stderr, "QueueTxMsg: out of memory\n");
+			return FL2K_433_ERROR_OUTOFMEM;
+		}
+		TxResample(msg_in, msg_out);
+		TxLock(fl2k, msg_out);
+		if (TxPushAt(fl2k, msg_out, samp_rate)) return 0;
+		TxFree(msg_out); // a reconfiguration started meanwhile, resample to the upcoming rate
+	}
+}
+
+typedef struct _TxBatch {
+	TxMsg *in;
+	TxNode **out;
+} TxBatch;
+
+static void TxBatchResample(void *ctx, uint32_t idx) {
+	TxBatch *batch = (TxBatch*)ctx;
+	TxResample(&batch->in[idx], batch->out[idx]);
+}
+
+// Queues n messages at once. Either all of them get queued or none (return value < 0)
+// important: target sample rate must have already been set when queuing TX messages
+FL2K_433_API int QueueTxMsgBatch(fl2k_433_t *fl2k, TxMsg *msgs, const uint32_t *gaps, uint32_t n) {
+	if (!msgs || !n) {
+		fl2k433_fprintf(stderr, "QueueTxMsgBatch: mandatory parameter is not set.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+
+	// 1) validate all messages before touching anything
+	for (uint32_t a = 0; a < n; a++) {
+		if (!TxMsgValid(&msgs[a]) ||
+			(msgs[a].mod != MODULATION_TYPE_SINE && msgs[a].mod != MODULATION_TYPE_OOK && msgs[a].mod != MODULATION_TYPE_FSK)) {
+			fl2k433_fprintf(stderr, "QueueTxMsgBatch: Malformed TX message #%lu, batch can not be queued\n", a);
+			return -1;
+		}
+	}
+
+	TxNode **out = (TxNode**)calloc(n, sizeof(TxNode*));
+	if (!out) {
+		fl2k433_fprintf(stderr, "QueueTxMsgBatch: out of memory\n");
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	for (;;) {
+		// 2) allocate all queue objects up front
+		uint32_t samp_rate = TxQueueRate(fl2k);
+		uint64_t total_len = 0;
+		uint32_t allocated = 0;
+		for (; allocated < n; allocated++) {
+			out[allocated] = TxAlloc(&msgs[allocated], (gaps ? gaps[allocated] : 0), samp_rate, 1);
+			if (!out[allocated]) break;
+			total_len += out[allocated]->len;
+		}
+		if (allocated < n) {
+			fl2k433_fprintf(stderr, "QueueTxMsgBatch: out of memory\n");
+			for (uint32_t a = 0; a < allocated; a++) TxFree(out[a]);
+			free(out);
+			return FL2K_433_ERROR_OUTOFMEM;
+		}
+
+		// 3) resample all messages in a single pass (spread over all cores if the batch is large)
+		TxBatch batch;
+		batch.in = msgs;
+		batch.out = out;
+		if (total_len >= FL2K_433_BATCH_PARALLEL_MIN) {
+			TpoolSched sched;
+			Tpool_parallelFor(n, 0, TxBatchResample, &batch, SchedCfg(fl2k, &sched));
+		}
+		else Tpool_parallelFor(n, 1, TxBatchResample, &batch, NULL);
+
+		// 4) chain them and append the chain to the queue at once
+		for (uint32_t a = 0; a < n; a++) TxLock(fl2k, out[a]);
+		for (uint32_t a = 0; a + 1 < n; a++) out[a]->next = out[a + 1];
+		if (TxPushAt(fl2k, out[0], samp_rate)) break;
+		for (uint32_t a = 0; a < n; a++) TxFree(out[a]); // a reconfiguration started meanwhile, resample to the upcoming rate
+	}
+	free(out);
+	return 0;
+}
+
+// important: target sample rate must have already been set when queuing a TX source
+FL2K_433_API int QueueTxSource(fl2k_433_t *fl2k, TxSource *src) {
+	if (!src || (src->mod != MODULATION_TYPE_OOK && src->mod != MODULATION_TYPE_FSK)) {
+		fl2k433_fprintf(stderr, "QueueTxSource: Malformed TX source object can not be queued\n");
+		return -1;
+	}
+	TxNode *msg_out = calloc(1, sizeof(TxNode));
+	if (msg_out) msg_out->buf = (char*)malloc(FL2K_BUF_LEN); // window into the stream, refilled by fl2k_callback
+	if (!msg_out || !msg_out->buf) {
+		fl2k433_fprintf(stderr, "QueueTxSource: out of memory\n");
+		if (msg_out) free(msg_out);
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	msg_out->mod = src->mod;
+	msg_out->samp_rate = fl2k->cfg.samp_rate;
+	msg_out->len = 0; // nothing rendered yet
+	msg_out->src = src;
+	TxLock(fl2k, msg_out);
+	TxPush(fl2k, msg_out);
+	return 0;
+}
+
+// The capture must have been recorded with the current sample rate and carrier(s), as encoded in its file name
+FL2K_433_API int QueueReplayFile(fl2k_433_t *fl2k, const char *path) {
+	int mod;
+	uint32_t samp_rate, carrier1, carrier2;
+	if (!path || !ReplayMap_parseName(path, &mod, &samp_rate, &carrier1, &carrier2)) {
+		fl2k433_fprintf(stderr, "QueueReplayFile: File name is not the one of a file mode capture\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	if (samp_rate != fl2k->cfg.samp_rate || carrier1 != fl2k->cfg.carrier1 || (mod != MODULATION_TYPE_OOK && carrier2 != fl2k->cfg.carrier2)) {
+		fl2k433_fprintf(stderr, "QueueReplayFile: Capture %s doesn't match the current sample rate/carrier settings\n", path);
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+
+	ReplayMap *map = NULL;
+	if (!ReplayMap_open(path, &map)) return FL2K_433_ERROR_INTERNAL;
+	if (map->len > UINT32_MAX) {
+		fl2k433_fprintf(stderr, "QueueReplayFile: Capture %s is too large\n", path);
+		ReplayMap_close(map);
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	TxNode *msg_out = calloc(1, sizeof(TxNode));
+	if (!msg_out) {
+		ReplayMap_close(map);
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	msg_out->mod = MODULATION_TYPE_RAW;
+	msg_out->samp_rate = samp_rate;
+	msg_out->buf = map->data;
+	msg_out->len = (uint32_t)map->len;
+	msg_out->map = map;
+	ReplayMap_prefetch(map, 0, REPLAY_READAHEAD);
+	TxPush(fl2k, msg_out);
+	return 0;
 }
 
 FL2K_433_API int getQueueLength(fl2k_433_t *fl2k) {
 	int num = 0;
-	TxMsg **ptr = &fl2k->txqueue;
-	while (*ptr) {
-		num++;
-		ptr = &(*ptr)->next;
-	}
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	for (TxNode *msg = fl2k->txqueue; msg; msg = msg->next) num++;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
 	return num;
 }
 
-static unsigned long getMilliSeconds() {
+static uint64_t getMicroSeconds() {
 #ifdef _WIN32
-	return GetTickCount();
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	// split up, now * 1000000 would overflow after ~10.7 days of uptime (10 MHz counter)
+	return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000 + (uint64_t)((now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart);
 #else
 	struct timeval tv;
 	gettimeofday(&tv, NULL);
-	return (1000 * tv.tv_sec) + (tv.tv_usec / 1000);
+	return (1000000 * (uint64_t)tv.tv_sec) + tv.tv_usec;
 #endif
 }
 
-static char zero_buf[FL2K_BUF_LEN] = { 0 }; // empty buffer as fallback (errors like missing context, ...) or if no more payload is waiting to be sent
-
-static void fl2k_callback(fl2k_data_info_t *data_info) {
-	if (!data_info || !data_info->ctx) return;
+// Maps a signal sample to the frequency to be generated for it
+static unsigned long SignalFreq(fl2k433cfg *cfg, mod_type mod, char crnt) {
+	unsigned long freq = 0; // generate 0 MHz signal if we are ourside our signal
+	if (crnt > 0) freq = cfg->carrier1; // set high samples to sine with primary carrier freq (OOK+FSK). 
+	else if (crnt == 0) freq = (mod == MODULATION_TYPE_FSK ? cfg->carrier2 : 0); // set low samples to sine with secondary carrier freq (FSK) or to 0 MHz for OOK
+	return freq;
+}
 
-	data_info->sampletype_signed = 1;
-	data_info->r_buf = zero_buf; // more bad cases than good cases, so we choose the zero array by default
+// Render kernels. Each one is chosen once per message (segment), so the per-sample loops (SineGen_fill) carry no branches.
 
-	// check context and fill data_info
-	fl2k_433_t *fl2k = (fl2k_433_t*)data_info->ctx;
-	if(!fl2k){
-		fl2k433_fprintf(stderr, "fl2k_callback: Missing context, providing NULL samples.\n");
-		return;
+// OOK: splits the signal into runs of equal samples. High runs get the carrier, the others 0 MHz.
+// Runs must end exactly where RenderSkip ends them (every SineGen_configure truncates the phase)
+static void RenderOok(SineGen *sg, uint32_t samp_rate, unsigned long freq, char *sig, uint32_t n, char *out) {
+	uint32_t a = 0;
+	while (a < n) {
+		char crnt = sig[a];
+		uint32_t run = a + 1;
+		while (run < n && sig[run] == crnt) run++;
+		SineGen_configure(sg, samp_rate, (crnt > 0 ? freq : 0));
+		SineGen_fill(sg, &out[a], run - a);
+		a = run;
 	}
-	if (!fl2k->sg) {
-		fl2k433_fprintf(stderr, "fl2k_callback: Missing sine generator, providing NULL samples.\n");
-		return;
+}
+
+// FSK: splits the signal into runs of equal samples. High runs get the primary carrier, low (0) runs the secondary one,
+// samples outside the signal (< 0) 0 MHz
+static void RenderFsk(SineGen *sg, uint32_t samp_rate, unsigned long freq_hi, unsigned long freq_lo, char *sig, uint32_t n, char *out) {
+	uint32_t a = 0;
+	while (a < n) {
+		char crnt = sig[a];
+		uint32_t run = a + 1;
+		while (run < n && sig[run] == crnt) run++;
+		SineGen_configure(sg, samp_rate, (crnt > 0 ? freq_hi : (crnt == 0 ? freq_lo : 0)));
+		SineGen_fill(sg, &out[a], run - a);
+		a = run;
 	}
+}
 
-	// if we are in device mode, give the adapter some time to initialize (output nullsamples only)
-	if (fl2k->opstate == FL2K433_STARTUP_FL2K && fl2k->cfg.inittime_ms > 0 && fl2k->starttime && getMilliSeconds() < (fl2k->starttime + fl2k->cfg.inittime_ms)) {
-		return; // output NULL samples during starting phase
+// SINE: continuous wave with the given frequency (0 = silence)
+static void RenderSine(SineGen *sg, uint32_t samp_rate, unsigned long freq, char *out, uint32_t n) {
+	SineGen_configure(sg, samp_rate, freq);
+	SineGen_fill(sg, out, n);
+}
+
+// Composes one output buffer (out_len samples) from the OOK/FSK signal sig. Exceeding the signal, 0 MHz is generated
+static void RenderSignal(SineGen *sg, fl2k433cfg *cfg, mod_type mod, char *sig, uint32_t sig_len, char *out, uint32_t out_len) {
+	uint32_t n = min(sig_len, out_len);
+	if (n > 0 && mod == MODULATION_TYPE_FSK) RenderFsk(sg, cfg->samp_rate, cfg->carrier1, cfg->carrier2, sig, n, out);
+	else if (n > 0) RenderOok(sg, cfg->samp_rate, cfg->carrier1, sig, n, out);
+	if (n < out_len) RenderSine(sg, cfg->samp_rate, 0, &out[n], out_len - n);
+}
+
+// Reference composer: the former per-sample loop (end of signal, level change and modulation checked for every sample).
+// Produces the same samples as the kernels above. Only used to measure their speedup (BenchSynthesis, see ref_render)
+static void RenderReference(SineGen *sg, fl2k433cfg *cfg, mod_type mod, char *sig, uint32_t sig_len, char *out, uint32_t out_len) {
+	char prev = -3; // no prev
+	for (uint32_t a = 0; a < out_len; a++) {
+		char crnt = (mod == MODULATION_TYPE_SINE ? 1 : (a < sig_len ? sig[a] : -2)); // -2: exceeded end of signal
+		if (crnt != prev) { // reconfigure sine generator only when signal state has changed
+			SineGen_configure(sg, cfg->samp_rate, (mod == MODULATION_TYPE_SINE ? cfg->carrier1 : SignalFreq(cfg, mod, crnt)));
+			prev = crnt;
+		}
+		out[a] = SineGen_getSample(sg);
 	}
-	if (fl2k->opstate == FL2K433_STARTUP_FL2K && fl2k->starttime) {
-		fl2k->starttime = 0;
+}
+
+// Advances the sine generator exactly like RenderSignal does, without producing any samples
+static void RenderSkip(SineGen *sg, fl2k433cfg *cfg, mod_type mod, char *sig, uint32_t sig_len, uint32_t out_len) {
+	uint32_t a = 0;
+	while (a < out_len) {
+		char crnt = (a < sig_len ? sig[a] : -2);
+		uint32_t run = a + 1;
+		if (crnt == -2) run = out_len;
+		else while (run < out_len && run < sig_len && sig[run] == crnt) run++;
+		SineGen_configure(sg, cfg->samp_rate, SignalFreq(cfg, mod, crnt));
+		sg->pos_numsteps += run - a;
+		a = run;
 	}
+}
 
-	// startup state ends here. Prepare for delivering samples...
-	if      (fl2k->opstate == FL2K433_STARTUP_FL2K) fl2k->opstate = FL2K433_RUNNING_FL2K;
-	else if (fl2k->opstate == FL2K433_STARTUP_FILE) fl2k->opstate = FL2K433_RUNNING_FILE;
-	data_info->r_buf = fl2k->txbuf;
+static char zero_buf[FL2K_BUF_LEN] = { 0 }; // empty buffer as fallback (errors like missing context, ...) or if no more payload is waiting to be sent
+
+// Composes (the next part of) the first message in the queue into txbuf, starting at position pos.
+// Returns the number of samples composed (0 if there's nothing to send). *finished is set if the message was removed from the queue,
+// *gap receives the pause requested after it (samples)
+static uint32_t ComposeMsg(fl2k_433_t *fl2k, fl2k_data_info_t *data_info, uint32_t pos, int *finished, uint32_t *gap) {
+	uint32_t space = sizeof(fl2k->txbuf) - pos;
+	*finished = 0;
+	*gap = 0;
 
-	// Preparatory checks: Is everything there we need to generate some signal?
-	int no_sig = 0; // will be set to > 0 if we just need to output silence (0 MHz). It's the case, if...
-	if (!fl2k->txqueue) no_sig = 1; //  ...there's nothing in the queue or...
-	else if (fl2k->txqueue->mod < MODULATION_TYPE_OOK || fl2k->txqueue->mod > MODULATION_TYPE_SINE){ // ...if we find an unknown modulation type or...
+	// Streaming sources: render the next window of the stream (at most one buffer). Drop sources that have run dry
+	TxNode *msg = TxPeek(fl2k);
+	while (msg && msg->src && fl2k->txqueue_sent >= msg->len) {
+		msg->len = TxSource_render(msg->src, msg->buf, FL2K_BUF_LEN, fl2k->cfg.samp_rate);
+		fl2k->txqueue_sent = 0;
+		if (msg->len > 0) break;
+		if (fl2k->cfg.verbose > 1) fl2k433_fprintf(stdout, "fl2k_callback: finished sending a stream.\n");
+		TxRelease(fl2k, TxPop(fl2k));
+		msg = TxPeek(fl2k);
+		*finished = 1;
+		// file mode only: inform caller about finished message (closes its output file before the next message is written)
+		if (fl2k->opstate == FL2K433_RUNNING_FILE) {
+			fl2k_data_info_fm_t *extdat = (fl2k_data_info_fm_t*)data_info;
+			extdat->msg_finished = 1;
+			return 0;
+		}
+	}
+
+	// Preparatory checks: Is everything there we need to generate some signal? We just need to output silence (0 MHz), if...
+	if (!msg) return 0; //  ...there's nothing in the queue or...
+	if (msg->mod < MODULATION_TYPE_OOK || msg->mod > MODULATION_TYPE_RAW){ // ...if we find an unknown modulation type or...
 		fl2k433_fprintf(stderr, "fl2k_callback: Unknown modulation type.\n");
-		no_sig = 1;
+		return 0;
 	}
-	else if (fl2k->txqueue->mod != MODULATION_TYPE_SINE && (!fl2k->txqueue->buf || !fl2k->txqueue->len)) { // .. if the message has no data (internal error)...
+	if (msg->mod != MODULATION_TYPE_SINE && (!msg->buf || !msg->len)) { // .. if the message has no data (internal error)...
 		fl2k433_fprintf(stderr, "fl2k_callback: Unexpected condition, TX message has no data.\n");
-		no_sig = 1;
+		return 0;
 	}
-	if(no_sig) {
-		SineGen_configure(fl2k->sg, fl2k->cfg.samp_rate, 0);
-		for (uint32_t a = 0; a < sizeof(fl2k->txbuf) /*FL2K_BUF_LEN*/; a++) {
-			fl2k->txbuf[a] = SineGen_getSample(fl2k->sg);
-		}
-		return;
+
+	// After a live reconfiguration, queued OOK/FSK messages carry the signal txreconfigure prepared for the new rate
+	// (swapped in by ApplyRetune). Messages already queued for an upcoming rate wait until it is applied. Captures and
+	// messages that couldn't be prepared are dropped. Streams render at the current sample rate anyway
+	if (msg->samp_rate != fl2k->cfg.samp_rate && !msg->src &&
+		(msg->mod == MODULATION_TYPE_OOK || msg->mod == MODULATION_TYPE_FSK || msg->mod == MODULATION_TYPE_RAW)) {
+		Tpool_mutexLock(fl2k->txqueue_mtx);
+		int upcoming = (msg->mod != MODULATION_TYPE_RAW && msg->samp_rate == TxQueueRateLocked(fl2k));
+		Tpool_mutexUnlock(fl2k->txqueue_mtx);
+		if (upcoming) return 0; // output silence until the new rate is applied
+		fl2k433_fprintf(stderr, "fl2k_callback: TX message can't be adapted to the new sample rate, dropping it.\n");
+		TxRelease(fl2k, TxPop(fl2k));
+		*finished = 1;
+		return 0;
 	}
 
 	// =========== If we reach here, we have some message to transmit =============
@@ -240,44 +682,49 @@ static void fl2k_callback(fl2k_data_info_t *data_info) {
 	// file mode only: inform caller about contained message
 	if (fl2k->opstate == FL2K433_RUNNING_FILE) {
 		fl2k_data_info_fm_t *extdat = (fl2k_data_info_fm_t*)data_info;
-		extdat->msg_mod = fl2k->txqueue->mod;
+		extdat->msg_mod = msg->mod;
 	}
 
+	uint32_t n = space;
+	int zerocopy = 0; // r_buf points into the message itself
 	// SINE: Set samples to a continuous sine wave (test purposes)
-	if (fl2k->txqueue->mod == MODULATION_TYPE_SINE) {
-		SineGen_configure(fl2k->sg, fl2k->cfg.samp_rate, fl2k->cfg.carrier1);
-		for (uint32_t a = 0; a < sizeof(fl2k->txbuf) /*FL2K_BUF_LEN*/; a++) {
-			fl2k->txbuf[a] = SineGen_getSample(fl2k->sg);
+	if (msg->mod == MODULATION_TYPE_SINE) {
+		if (fl2k->ref_render) RenderReference(fl2k->sg, &fl2k->cfg, msg->mod, NULL, 0, &fl2k->txbuf[pos], space);
+		else RenderSine(fl2k->sg, fl2k->cfg.samp_rate, fl2k->cfg.carrier1, &fl2k->txbuf[pos], space);
+	}
+	// RAW: Pass the pre-rendered samples through. Full buffers are handed to libosmo-fl2k without copying
+	else if (msg->mod == MODULATION_TYPE_RAW) {
+		uint32_t left = msg->len - fl2k->txqueue_sent;
+		if (pos == 0 && left >= sizeof(fl2k->txbuf)) {
+			data_info->r_buf = &msg->buf[fl2k->txqueue_sent];
+			zerocopy = 1;
 		}
+		else {
+			n = min(left, space);
+			memcpy(&fl2k->txbuf[pos], &msg->buf[fl2k->txqueue_sent], n);
+		}
+		fl2k->txqueue_sent += n;
+		if (msg->map) ReplayMap_prefetch(msg->map, fl2k->txqueue_sent, REPLAY_READAHEAD); // stay ahead of USB demand
 	}
 	// OOK / FSK: Compose signal from samples of primary and secondary carrier
 	else {
-		// Compose final signal segment into txbuf
-		char *sig_s = &fl2k->txqueue->buf[fl2k->txqueue_sent]; // start of (remaining) tx signal
-		char *sig_e = &fl2k->txqueue->buf[fl2k->txqueue->len]; // end of tx signal
 		if (fl2k->cfg.verbose > 1 && fl2k->txqueue_sent == 0) fl2k433_fprintf(stdout, "fl2k_callback: start sending an OOK signal.\n");
-		char prev = -1; // -1 is just a placeholder for "no prev"
-		for (uint32_t a = 0; a < sizeof(fl2k->txbuf) /*FL2K_BUF_LEN*/; a++) {
-			char crnt = (&sig_s[a] < sig_e ? sig_s[a] : -2); // -2 is just a placeholder for "exceeded end of signal"
-			if (crnt != prev) { // reconfigure sine generator only when signal state has changed
-				unsigned long freq = 0; // generate 0 MHz signal if we are ourside our signal
-				if (crnt > 0) freq = fl2k->cfg.carrier1; // set high samples to sine with primary carrier freq (OOK+FSK). 
-				else if (crnt == 0) freq = (fl2k->txqueue->mod == MODULATION_TYPE_FSK ? fl2k->cfg.carrier2 : 0); // set low samples to sine with secondary carrier freq (FSK) or to 0 MHz for OOK
-				SineGen_configure(fl2k->sg, fl2k->cfg.samp_rate, freq);
-				prev = crnt;
-			}
-			fl2k->txbuf[a] = SineGen_getSample(fl2k->sg);
-		}
-		fl2k->txqueue_sent += sizeof(fl2k->txbuf);
+		n = min(msg->len - fl2k->txqueue_sent, space);
+		if (fl2k->ref_render) RenderReference(fl2k->sg, &fl2k->cfg, msg->mod, &msg->buf[fl2k->txqueue_sent], n, &fl2k->txbuf[pos], n);
+		else RenderSignal(fl2k->sg, &fl2k->cfg, msg->mod, &msg->buf[fl2k->txqueue_sent], n, &fl2k->txbuf[pos], n);
+		fl2k->txqueue_sent += n;
 	}
 
 	// remove TX message and free its memory if it has been sent completely (or if a continuos SINE wave got sent in file mode, because we won't save an infinite stream here)
-	if ((fl2k->txqueue->mod == MODULATION_TYPE_SINE && fl2k->opstate == FL2K433_RUNNING_FILE) ||
-		(fl2k->txqueue_sent >= fl2k->txqueue->len)) {
+	// (streaming sources are only complete after they reported their end)
+	if ((msg->mod == MODULATION_TYPE_SINE && fl2k->opstate == FL2K433_RUNNING_FILE) ||
+		(fl2k->txqueue_sent >= msg->len && (!msg->src || msg->src->eof))) {
 		if(fl2k->cfg.verbose > 1) fl2k433_fprintf(stdout, "fl2k_callback: finished sending.\n");
-		TxMsg *m = TxPop(fl2k); // will clear txqueue_sent
-		if(m->buf) free(m->buf);
-		free(m);
+		*gap = msg->gap;
+		// will clear txqueue_sent. Zero-copy: r_buf is read after we return, so the message is freed by the next callback
+		if (zerocopy) fl2k->txretired = TxPop(fl2k);
+		else TxRelease(fl2k, TxPop(fl2k));
+		*finished = 1;
 
 		// file mode only: inform caller about finished message
 		if (fl2k->opstate == FL2K433_RUNNING_FILE) {
@@ -285,10 +732,178 @@ static void fl2k_callback(fl2k_data_info_t *data_info) {
 			extdat->msg_finished = 1;
 		}
 	}
+	return n;
+}
+
+// Swaps in the configuration prepared by txreconfigure. Runs in the callback, between two buffers (or in txreconfigure
+// while stopped). No allocation or resampling here, the queued messages were prepared by txreconfigure already.
+// Note: the new rate is set on the device right away, but libosmo-fl2k still holds a few buffers rendered for the old
+// rate in its transfer queue. Those are played at the new rate, so the switch is not atomic on air (a few ms of
+// distorted signal, like any rate change while streaming)
+static void ApplyRetune(fl2k_433_t *fl2k) {
+	uint32_t old_rate = fl2k->cfg.samp_rate;
+	if (fl2k->retune_samp_rate != old_rate && fl2k->dev && fl2k_set_sample_rate(fl2k->dev, fl2k->retune_samp_rate) < 0) {
+		fl2k433_fprintf(stderr, "fl2k_callback: Failed to set sample rate, keeping the current configuration.\n");
+		Tpool_mutexLock(fl2k->txqueue_mtx);
+		fl2k->retune_pending = 0; // messages queued for the new rate meanwhile get dropped
+		Tpool_mutexUnlock(fl2k->txqueue_mtx);
+		return;
+	}
+	if (fl2k->retune_samp_rate != old_rate) {
+		// pending pauses are counted in samples, keep their duration
+		double scale_factor = (double)fl2k->retune_samp_rate / (double)old_rate;
+		fl2k->gap_left = (uint64_t)((double)fl2k->gap_left * scale_factor);
+		fl2k->warmup_left = (uint64_t)((double)fl2k->warmup_left * scale_factor);
+	}
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	TxSwapPrepared(fl2k, fl2k->retune_samp_rate);
+	fl2k->cfg.samp_rate = fl2k->retune_samp_rate;
+	fl2k->cfg.carrier1 = fl2k->retune_carrier1;
+	fl2k->cfg.carrier2 = fl2k->retune_carrier2;
+	fl2k->retune_pending = 0;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	if (fl2k->cfg.verbose > 0) fl2k433_fprintf(stdout, "fl2k_callback: reconfigured to sample rate %lu, carriers %lu / %lu.\n", fl2k->cfg.samp_rate, fl2k->cfg.carrier1, fl2k->cfg.carrier2);
+}
+
+static void fl2k_callback(fl2k_data_info_t *data_info) {
+	if (!data_info || !data_info->ctx) return;
+
+	data_info->sampletype_signed = 1;
+	data_info->r_buf = zero_buf; // more bad cases than good cases, so we choose the zero array by default
+
+	// check context and fill data_info
+	fl2k_433_t *fl2k = (fl2k_433_t*)data_info->ctx;
+	if(!fl2k){
+		fl2k433_fprintf(stderr, "fl2k_callback: Missing context, providing NULL samples.\n");
+		return;
+	}
+	if (!fl2k->sg) {
+		fl2k433_fprintf(stderr, "fl2k_callback: Missing sine generator, providing NULL samples.\n");
+		return;
+	}
+
+	// the buffer passed by the last callback has been consumed by now
+	if (fl2k->txretired) {
+		TxRelease(fl2k, fl2k->txretired);
+		fl2k->txretired = NULL;
+	}
+
+	// FL2K mode: configure the libosmo-fl2k thread that calls us on its first callback
+	if (fl2k->opstate == FL2K433_STARTUP_FL2K && !fl2k->sched_applied) {
+		TpoolSched sched;
+		Tpool_applySched(SchedCfg(fl2k, &sched), "fl2k_callback");
+		fl2k->sched_applied = 1;
+	}
+
+	// apply a pending live reconfiguration at this buffer boundary
+	if (fl2k->retune_pending) ApplyRetune(fl2k);
+
+	// if we are in device mode, give the adapter some time to initialize (output nullsamples only)
+	uint32_t pos = 0; // position in txbuf where the payload starts
+	if (fl2k->opstate == FL2K433_STARTUP_FL2K && fl2k->warmup_left > 0) {
+		if (fl2k->warmup_left >= sizeof(fl2k->txbuf)) {
+			fl2k->warmup_left -= sizeof(fl2k->txbuf);
+			return; // output NULL samples during starting phase
+		}
+		pos = (uint32_t)fl2k->warmup_left; // starting phase ends within this buffer
+		fl2k->warmup_left = 0;
+		memset(fl2k->txbuf, 0, pos);
+	}
+
+	// startup state ends here. Prepare for delivering samples...
+	if      (fl2k->opstate == FL2K433_STARTUP_FL2K) fl2k->opstate = FL2K433_RUNNING_FL2K;
+	else if (fl2k->opstate == FL2K433_STARTUP_FILE) fl2k->opstate = FL2K433_RUNNING_FILE;
+	data_info->r_buf = fl2k->txbuf;
 
+	// Compose as many messages as fit into the buffer, back to back. Each one starts at a multiple of the message alignment,
+	// after the gap requested by its predecessor (file mode: one message per buffer and file, no gaps)
+	uint32_t align = (fl2k->opstate == FL2K433_RUNNING_FILE ? FL2K_BUF_LEN : fl2k->cfg.msg_align);
+	while (pos < sizeof(fl2k->txbuf)) {
+		if (fl2k->gap_left > 0) { // pause between two messages (may span several buffers)
+			uint32_t n = (uint32_t)min(fl2k->gap_left, sizeof(fl2k->txbuf) - pos);
+			RenderSignal(fl2k->sg, &fl2k->cfg, MODULATION_TYPE_NONE, NULL, 0, &fl2k->txbuf[pos], n);
+			fl2k->gap_left -= n;
+			pos += n;
+			continue;
+		}
+		int finished;
+		uint32_t gap;
+		uint32_t n = ComposeMsg(fl2k, data_info, pos, &finished, &gap);
+		pos += n;
+		if (!finished) {
+			if (!n) break; // nothing (more) to send
+			continue;
+		}
+		if (fl2k->opstate == FL2K433_RUNNING_FILE) break;
+		uint32_t next = (uint32_t)min(((uint64_t)pos + align - 1) / align * align, sizeof(fl2k->txbuf));
+		if (next > pos) RenderSignal(fl2k->sg, &fl2k->cfg, MODULATION_TYPE_NONE, NULL, 0, &fl2k->txbuf[pos], next - pos);
+		pos = next;
+		fl2k->gap_left = gap;
+	}
+	// output silence (0 MHz) for the rest of the buffer
+	if (pos < sizeof(fl2k->txbuf)) RenderSignal(fl2k->sg, &fl2k->cfg, MODULATION_TYPE_NONE, NULL, 0, &fl2k->txbuf[pos], sizeof(fl2k->txbuf) - pos);
 	return;
 }
 
+// Changes sample rate and carriers without stopping TX. Queued OOK/FSK messages are resampled (from their original
+// input) here, in the calling thread. The callback then applies the new settings at the next buffer boundary and swaps
+// in the prepared signals. Returns 1 on success (applied or scheduled)
+FL2K_433_API int txreconfigure(fl2k_433_t *fl2k, uint32_t samp_rate, uint32_t carrier1, uint32_t carrier2) {
+	if (!fl2k || !samp_rate || !carrier1) {
+		fl2k433_fprintf(stderr, "txreconfigure(): mandatory parameter is not set.\n");
+		return 0;
+	}
+	double samplesPerCycle = (double)samp_rate / (double)carrier1;
+	if (samplesPerCycle < 2.0 && fl2k->cfg.verbose > 0) fl2k433_fprintf(stderr, "Warning: Frequency of primary carrier signal (%lu) higher than %lu, violating Nyquist theoreom.\n", carrier1, (samp_rate + 1) / 2);
+
+	// 1) from now on, new messages are resampled to the new rate and finished messages are not freed (see TxRelease)
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	if (fl2k->retune_busy || fl2k->retune_pending) {
+		Tpool_mutexUnlock(fl2k->txqueue_mtx);
+		fl2k433_fprintf(stderr, "txreconfigure(): previous reconfiguration has not been applied yet.\n");
+		return 0;
+	}
+	fl2k->retune_busy = 1;
+	fl2k->retune_samp_rate = samp_rate;
+	fl2k->retune_carrier1 = carrier1;
+	fl2k->retune_carrier2 = carrier2;
+	uint32_t n = 0;
+	for (TxNode *msg = fl2k->txqueue; msg; msg = msg->next) n++;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+
+	// 2) collect the messages queued for the old rate (later ones already have the new rate)
+	TxNode **msgs = (n ? (TxNode**)malloc(n * sizeof(TxNode*)) : NULL);
+	if (msgs) {
+		Tpool_mutexLock(fl2k->txqueue_mtx);
+		uint32_t a = 0;
+		for (TxNode *msg = fl2k->txqueue; msg && a < n; msg = msg->next) msgs[a++] = msg;
+		n = a;
+		Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	}
+	else if (n) fl2k433_fprintf(stderr, "txreconfigure(): out of memory, queued messages will be dropped.\n");
+
+	// 3) resample them outside the callback. They stay valid while retune_busy is set
+	for (uint32_t a = 0; msgs && a < n; a++) {
+		if (!TxPrepare(msgs[a], samp_rate)) fl2k433_fprintf(stderr, "txreconfigure(): out of memory, a queued message will be dropped.\n");
+	}
+	if (msgs) free(msgs);
+
+	// 4) hand over to the callback (or apply directly if it isn't running)
+	Tpool_mutexLock(fl2k->txqueue_mtx);
+	TxNode *done = fl2k->retune_done;
+	fl2k->retune_done = NULL;
+	fl2k->retune_busy = 0;
+	fl2k->retune_pending = 1;
+	Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	if (fl2k->opstate == FL2K433_STOPPED) ApplyRetune(fl2k);
+	while (done) {
+		TxNode *msg = done;
+		done = msg->next;
+		TxFree(msg);
+	}
+	return 1;
+}
+
 FL2K_433_API int txstart(fl2k_433_t *fl2k) {
 	int r = 0; // 0 = failure, 1 = success
 
@@ -302,14 +917,33 @@ FL2K_433_API int txstart(fl2k_433_t *fl2k) {
 		return r;
 	}
 
+	if (fl2k->cfg.msg_align < 1 || fl2k->cfg.msg_align > FL2K_BUF_LEN) {
+		fl2k433_fprintf(stderr, "start(): Message alignment %lu is out of range (1..%lu).\n", fl2k->cfg.msg_align, (uint32_t)FL2K_BUF_LEN);
+		return r;
+	}
+
 	fl2k->opstate = (fl2k->cfg.out_dir[0] ? FL2K433_STARTUP_FILE : FL2K433_STARTUP_FL2K);
 	fl2k->txqueue_sent = 0;
 
 	double samplesPerCycle = (double)fl2k->cfg.samp_rate / (double)fl2k->cfg.carrier1;
 	if (samplesPerCycle < 2.0 && fl2k->cfg.verbose > 0) fl2k433_fprintf(stderr, "Warning: Frequency of primary carrier signal (%lu) higher than %lu, violating Nyquist theoreom.\n", fl2k->cfg.carrier1, (fl2k->cfg.samp_rate + 1) / 2);
 
+	fl2k->gap_left = 0;
+	if (fl2k->retune_pending) ApplyRetune(fl2k); // scheduled while the last run was stopping
+	fl2k->sched_applied = 0;
+
+	// lock the instance (tx buffer) and the signals of all queued messages into RAM. Messages queued later on get locked
+	// by QueueTxMsg & co. Only these ranges are locked, the rest of the host process is left alone
+	int locked = (fl2k->cfg.mem_lock ? Tpool_lockMemory(fl2k, sizeof(fl2k_433_t)) : 0);
+	if (locked) {
+		Tpool_mutexLock(fl2k->txqueue_mtx);
+		fl2k->mem_locked = 1;
+		for (TxNode *msg = fl2k->txqueue; msg; msg = msg->next) TxLock(fl2k, msg);
+		Tpool_mutexUnlock(fl2k->txqueue_mtx);
+	}
+
 	if(fl2k->opstate == FL2K433_STARTUP_FL2K){
-		fl2k->starttime = getMilliSeconds();
+		fl2k->warmup_left = (fl2k->cfg.init_samples ? fl2k->cfg.init_samples : ((uint64_t)fl2k->cfg.inittime_ms * fl2k->cfg.samp_rate) / 1000);
 		if (InitFl2k(fl2k)) {
 			if (fl2k->cfg.verbose > 0) fl2k433_fprintf(stdout, "start(): fl2k_433 was started in FL2K mode.\n");
 			while (fl2k->opstate != FL2K433_STOPPED) sleep_ms(200);
@@ -326,6 +960,10 @@ FL2K_433_API int txstart(fl2k_433_t *fl2k) {
 		file_mode(fl2k);
 		r = 1;
 	}
+	if (locked) { // messages still queued stay locked until they are freed
+		fl2k->mem_locked = 0;
+		Tpool_unlockMemory(fl2k, sizeof(fl2k_433_t));
+	}
 	fl2k->opstate = FL2K433_STOPPED;
 	return r;
 }
@@ -390,6 +1028,9 @@ static FILE *openOutputFile(char *dir, mod_type mod, uint32_t samp_rate, uint32_
 		if (mod == MODULATION_TYPE_FSK) {
 			sprintf_s(fname, fname_cap, "FSK_s%lu_cp%lu_cs%lu_%lu.bin", samp_rate, carrier1, carrier2, *filenum); // todo: add time etc.?
 		}
+		else if (mod == MODULATION_TYPE_RAW) {
+			sprintf_s(fname, fname_cap, "RAW_s%lu_cp%lu_cs%lu_%lu.bin", samp_rate, carrier1, carrier2, *filenum); // todo: add time etc.?
+		}
 		else {
 			sprintf_s(fname, fname_cap, "OOK_s%lu_c%lu_%lu.bin", samp_rate, carrier1, *filenum); // todo: add time etc.?
 		}
@@ -453,6 +1094,208 @@ void *file_mode(fl2k_433_t *fl2k) {
 	return NULL;
 }
 
+// Stub device for offline checks (verify.c): Plays the part of libosmo-fl2k in FL2K mode (without starting phase) and pulls one
+// buffer from the callback. *elapsed_us receives the time spent in the callback. The instance must not be started, its
+// configuration is used as is (an invalid msg_align is rejected like txstart does)
+char *StubDevice_pull(fl2k_433_t *fl2k, uint64_t *elapsed_us) {
+	if (fl2k->cfg.msg_align < 1 || fl2k->cfg.msg_align > FL2K_BUF_LEN) {
+		fl2k433_fprintf(stderr, "StubDevice_pull: Message alignment %lu is out of range (1..%lu).\n", fl2k->cfg.msg_align, (uint32_t)FL2K_BUF_LEN);
+		return NULL;
+	}
+	fl2k_data_info_t di;
+	memset(&di, 0, sizeof(di));
+	di.ctx = fl2k;
+	di.len = FL2K_BUF_LEN;
+	fl2k433_state opstate = fl2k->opstate;
+	fl2k->opstate = FL2K433_RUNNING_FL2K; // the callback only composes messages in a running state
+	uint64_t t_start = getMicroSeconds();
+	fl2k_callback(&di);
+	*elapsed_us = getMicroSeconds() - t_start;
+	fl2k->opstate = opstate;
+	return di.r_buf;
+}
+
+typedef struct _RenderJob {
+	fl2k_433_t *fl2k;
+	TxMsg *msgs;
+	TpoolMutex *mtx;		// serializes the creation of output files and writes to the chunk mode file
+	int n_ok;				// number of messages written successfully (protected by mtx)
+
+	// chunk mode only (single long message rendered by several threads)
+	TxNode *msg;			// resampled message
+	FILE *file;				// output file of the message. Chunks are written as they complete
+	int failed;				// > 0 if a chunk could not be rendered or written (protected by mtx)
+	uint32_t chunk_bufs;	// number of FL2K buffers per chunk
+	uint32_t n_bufs;		// number of FL2K buffers of the whole message
+	SineGen *chunk_sg;		// generator state at the start of each chunk
+} RenderJob;
+
+// Number of FL2K buffers a message occupies in file mode
+static uint32_t RenderNumBufs(TxNode *msg) {
+	if (msg->mod == MODULATION_TYPE_SINE) return 1; // as in file mode, we only save one buffer of a continuous sine wave
+	return (uint32_t)(((uint64_t)msg->len + FL2K_BUF_LEN - 1) / FL2K_BUF_LEN);
+}
+
+// Renders FL2K buffer b of a message. Starting from the same generator state, results are identical to what file mode writes for it
+static void RenderBuf(SineGen *sg, fl2k433cfg *cfg, TxNode *msg, uint32_t b, char *out) {
+	if (msg->mod == MODULATION_TYPE_SINE) {
+		RenderSine(sg, cfg->samp_rate, cfg->carrier1, out, FL2K_BUF_LEN);
+	}
+	else {
+		uint32_t sent = b * FL2K_BUF_LEN;
+		RenderSignal(sg, cfg, msg->mod, &msg->buf[sent], msg->len - sent, out, FL2K_BUF_LEN);
+	}
+}
+
+// Opens the output file of message idx (serialized, so parallel workers don't pick the same file name)
+static FILE *RenderOpen(RenderJob *job, TxNode *msg, uint32_t idx) {
+	fl2k433cfg *cfg = &job->fl2k->cfg;
+	uint32_t filenum = idx + 1; // message i goes to file i+1 (or the next free one)
+	Tpool_mutexLock(job->mtx);
+	FILE *f = openOutputFile(cfg->out_dir, msg->mod, cfg->samp_rate, cfg->carrier1, cfg->carrier2, &filenum);
+	Tpool_mutexUnlock(job->mtx);
+	return f;
+}
+
+// Message mode: every worker renders complete messages, one FL2K buffer at a time
+static void RenderMsgWorker(void *ctx, uint32_t idx) {
+	RenderJob *job = (RenderJob*)ctx;
+	int ok = 0;
+	TxNode *msg = TxAlloc(&job->msgs[idx], 0, job->fl2k->cfg.samp_rate, 0);
+	SineGen sg = *job->fl2k->sg; // private generator state, starting at phase 0
+	sg.sine_step = 0.0;
+	sg.pos_startidx = 0;
+	sg.pos_numsteps = 0;
+	char *out = (msg ? (char*)malloc(FL2K_BUF_LEN) : NULL);
+	if (out) {
+		TxResample(&job->msgs[idx], msg);
+		FILE *f = RenderOpen(job, msg, idx);
+		if (f) {
+			ok = 1;
+			uint32_t n_bufs = RenderNumBufs(msg);
+			for (uint32_t b = 0; b < n_bufs && ok; b++) {
+				RenderBuf(&sg, &job->fl2k->cfg, msg, b, out);
+				ok = (fwrite(out, 1, FL2K_BUF_LEN, f) == FL2K_BUF_LEN);
+			}
+			if (!ok) fl2k433_fprintf(stderr, "RenderTxMsgs: Short write, samples lost.\n");
+			fclose(f);
+		}
+		free(out);
+	}
+	else fl2k433_fprintf(stderr, "RenderTxMsgs: out of memory for message #%lu\n", idx);
+	if (msg) TxFree(msg);
+
+	Tpool_mutexLock(job->mtx);
+	job->n_ok += ok;
+	Tpool_mutexUnlock(job->mtx);
+}
+
+// Chunk mode: every worker renders a range of buffers of the same message, starting from a precomputed phase.
+// Each buffer is written to its place in the file right away
+static void RenderChunkWorker(void *ctx, uint32_t idx) {
+	RenderJob *job = (RenderJob*)ctx;
+	SineGen sg = job->chunk_sg[idx];
+	int failed = 0;
+	char *out = (char*)malloc(FL2K_BUF_LEN);
+	uint32_t b_end = min((idx + 1) * job->chunk_bufs, job->n_bufs);
+	for (uint32_t b = idx * job->chunk_bufs; out && b < b_end && !failed; b++) {
+		RenderBuf(&sg, &job->fl2k->cfg, job->msg, b, out);
+		Tpool_mutexLock(job->mtx);
+		failed = (fseek64(job->file, (int64_t)b * FL2K_BUF_LEN, SEEK_SET) != 0 || fwrite(out, 1, FL2K_BUF_LEN, job->file) != FL2K_BUF_LEN);
+		Tpool_mutexUnlock(job->mtx);
+	}
+	if (out) free(out);
+	if (!out || failed) {
+		Tpool_mutexLock(job->mtx);
+		job->failed = 1;
+		Tpool_mutexUnlock(job->mtx);
+	}
+}
+
+static int RenderChunked(RenderJob *job, uint32_t idx, uint32_t nthreads) {
+	int ok = 0;
+	job->msg = TxAlloc(&job->msgs[idx], 0, job->fl2k->cfg.samp_rate, 0);
+	if (!job->msg) {
+		fl2k433_fprintf(stderr, "RenderTxMsgs: out of memory for message #%lu\n", idx);
+		return ok;
+	}
+	TxResample(&job->msgs[idx], job->msg);
+	job->n_bufs = RenderNumBufs(job->msg);
+	job->chunk_bufs = job->n_bufs / (4 * nthreads); // several chunks per thread for load balancing
+	if (job->chunk_bufs < 1) job->chunk_bufs = 1;
+	uint32_t n_chunks = (job->n_bufs + job->chunk_bufs - 1) / job->chunk_bufs;
+	job->chunk_sg = (SineGen*)malloc(n_chunks * sizeof(SineGen));
+	job->file = (job->chunk_sg ? RenderOpen(job, job->msg, idx) : NULL);
+	job->failed = 0;
+	if (job->file) {
+		// precompute the generator state at the start of each chunk (cheap: one configure per signal edge)
+		SineGen sg = *job->fl2k->sg;
+		sg.sine_step = 0.0;
+		sg.pos_startidx = 0;
+		sg.pos_numsteps = 0;
+		for (uint32_t b = 0; b < job->n_bufs; b++) {
+			if (b % job->chunk_bufs == 0) job->chunk_sg[b / job->chunk_bufs] = sg;
+			if (job->msg->mod == MODULATION_TYPE_SINE) break;
+			uint32_t sent = b * FL2K_BUF_LEN;
+			RenderSkip(&sg, &job->fl2k->cfg, job->msg->mod, &job->msg->buf[sent], job->msg->len - sent, FL2K_BUF_LEN);
+		}
+		TpoolSched sched;
+		Tpool_parallelFor(n_chunks, nthreads, RenderChunkWorker, job, SchedCfg(job->fl2k, &sched));
+		ok = !job->failed;
+		if (!ok) fl2k433_fprintf(stderr, "RenderTxMsgs: Short write, samples lost.\n");
+		fclose(job->file);
+	}
+	else if (!job->chunk_sg) fl2k433_fprintf(stderr, "RenderTxMsgs: out of memory for message #%lu\n", idx);
+	if (job->chunk_sg) free(job->chunk_sg);
+	TxFree(job->msg);
+	job->msg = NULL;
+	job->file = NULL;
+	job->chunk_sg = NULL;
+	return ok;
+}
+
+// Renders n messages into cfg.out_dir without a running TX thread, each message into its own file.
+// Every message starts at phase 0, i.e. its file equals the one file mode writes for it when it's the only message queued
+// (in a queue, file mode continues with the phase its predecessor ended with).
+// Messages are spread over the threads if there are enough of them, otherwise each message is split into chunks.
+FL2K_433_API int RenderTxMsgs(fl2k_433_t *fl2k, TxMsg *msgs, uint32_t n, uint32_t nthreads) {
+	if (!fl2k || !msgs || !n || !fl2k->cfg.out_dir[0]) {
+		fl2k433_fprintf(stderr, "RenderTxMsgs: mandatory parameter is not set.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	if (!fl2k->sg) {
+		fl2k433_fprintf(stderr, "RenderTxMsgs: Missing sine generator.\n");
+		return FL2K_433_ERROR_INTERNAL;
+	}
+	for (uint32_t a = 0; a < n; a++) {
+		if (!TxMsgValid(&msgs[a]) ||
+			(msgs[a].mod != MODULATION_TYPE_SINE && msgs[a].mod != MODULATION_TYPE_OOK && msgs[a].mod != MODULATION_TYPE_FSK)) {
+			fl2k433_fprintf(stderr, "RenderTxMsgs: Malformed TX message #%lu\n", a);
+			return FL2K_433_ERROR_INVALID_PARAM;
+		}
+	}
+	if (!nthreads) nthreads = Tpool_numCores();
+
+	RenderJob job;
+	memset(&job, 0, sizeof(job));
+	job.fl2k = fl2k;
+	job.msgs = msgs;
+	job.mtx = Tpool_mutexCreate();
+	if (!job.mtx) return FL2K_433_ERROR_OUTOFMEM;
+
+	if (n >= nthreads) {
+		TpoolSched sched;
+		Tpool_parallelFor(n, nthreads, RenderMsgWorker, &job, SchedCfg(fl2k, &sched));
+	}
+	else {
+		for (uint32_t a = 0; a < n; a++) job.n_ok += RenderChunked(&job, a, nthreads);
+	}
+	Tpool_mutexDestroy(job.mtx);
+
+	if (fl2k->cfg.verbose > 0) fl2k433_fprintf(stdout, "RenderTxMsgs: %d of %lu messages rendered.\n", job.n_ok, n);
+	return job.n_ok;
+}
+
 FL2K_433_API int txstop_signal(fl2k_433_t *fl2k) {
 	int r = 0;
 	if (fl2k->opstate == FL2K433_STOPPED) {
@@ -493,14 +1336,80 @@ FL2K_433_API int txstop_signal(fl2k_433_t *fl2k) {
 		fl2k_close(fl2k->dev);
 		fl2k->dev = NULL;
 	}
-	while (fl2k->txqueue) {
-		TxMsg *m = TxPop(fl2k);
-		if (m->buf) free(m->buf);
-		free(m);
+	TxNode *m;
+	while ((m = TxPop(fl2k)) != NULL) {
+		TxRelease(fl2k, m);
+	}
+	if (fl2k->txretired) {
+		TxRelease(fl2k, fl2k->txretired);
+		fl2k->txretired = NULL;
 	}
 	return 1;
 }
 
+typedef struct _DaemonCtx {
+	fl2k_433_t *fl2k;
+	Shmq *q;
+	volatile int stop;
+} DaemonCtx;
+
+// Moves messages committed by client processes from the shared ring into the TX queue.
+// Clients can write to the slot at any time, so only the copy of its header is used, and only after checking it.
+// Durations are bounded as well: a low samp_rate would otherwise blow up the resampled message (memory, resampling time)
+// and a huge gap would mute the device for hours
+static void DaemonWorker(void *ctx) {
+	DaemonCtx *d = (DaemonCtx*)ctx;
+	while (!d->stop) {
+		ShmqSlot slot;
+		char *payload;
+		if (!Shmq_next(d->q, &slot, &payload, DAEMON_POLL_TIME)) continue;
+		if (slot.len > d->q->slot_len || !slot.samp_rate ||
+			(uint64_t)slot.len * 1000 > (uint64_t)DAEMON_MAX_MSG_MS * slot.samp_rate ||
+			(uint64_t)slot.gap * 1000 > (uint64_t)DAEMON_MAX_GAP_MS * slot.samp_rate ||
+			(slot.mod != MODULATION_TYPE_OOK && slot.mod != MODULATION_TYPE_FSK && slot.mod != MODULATION_TYPE_SINE)) {
+			fl2k433_fprintf(stderr, "txdaemon: dropped a malformed client message.\n");
+			Shmq_release(d->q);
+			continue;
+		}
+		TxMsg msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.mod = (mod_type)slot.mod;
+		msg.buf = payload; // the slot is only released once QueueTxMsgEx has resampled it
+		msg.len = slot.len;
+		msg.samp_rate = slot.samp_rate;
+		if (QueueTxMsgEx(d->fl2k, &msg, slot.gap) != 0) fl2k433_fprintf(stderr, "txdaemon: dropped a malformed client message.\n");
+		Shmq_release(d->q);
+	}
+}
+
+// Daemon mode: owns the device (or file mode) and serves client processes that submit messages via the shared ring
+// named name (see Shmq_connect). Blocks like txstart until TX got stopped.
+FL2K_433_API int txdaemon(fl2k_433_t *fl2k, const char *name) {
+	DaemonCtx d;
+	d.fl2k = fl2k;
+	d.stop = 0;
+	d.q = Shmq_create(name, SHMQ_DEFAULT_SLOTS, SHMQ_DEFAULT_SLOT_LEN);
+	if (!d.q) {
+		fl2k433_fprintf(stderr, "txdaemon: shared message ring could not be created.\n");
+		return 0;
+	}
+	TpoolSched sched;
+	TpoolThread *worker = Tpool_threadStart(DaemonWorker, &d, SchedCfg(fl2k, &sched));
+	if (!worker) {
+		fl2k433_fprintf(stderr, "txdaemon: failed to start the ring worker.\n");
+		Shmq_destroy(d.q);
+		return 0;
+	}
+	if (fl2k->cfg.verbose > 0) fl2k433_fprintf(stdout, "txdaemon: serving clients on ring %s.\n", name);
+
+	int r = txstart(fl2k);
+
+	d.stop = 1;
+	Tpool_threadJoin(worker);
+	Shmq_destroy(d.q);
+	return r;
+}
+
 #define MAX_FL2K_CONFIGS 3725 // required place for 3411 useful and 309 redundant entries
 static Fl2kCfg configs[MAX_FL2K_CONFIGS];
 static uint32_t n_cfg_useful = 0;
@@ -0,0 +1,174 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <windows.h>
+#endif
+
+#include "libfl2k_433.h"
+#include "replay.h"
+#include "redir_print.h"
+
+#ifndef _WIN32
+int ReplayMap_open(const char *path, ReplayMap **out) {
+	if (!path || !out) return 0;
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: Failed to open %s\n", path);
+		return 0;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: %s is empty or can't be examined\n", path);
+		close(fd);
+		return 0;
+	}
+	// read-only: libosmo-fl2k only reads r_buf, and clean pages of a shared read-only mapping are simply re-read from the file
+	void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: Failed to map %s\n", path);
+		close(fd);
+		return 0;
+	}
+	madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	ReplayMap *map = (ReplayMap*)calloc(1, sizeof(ReplayMap));
+	if (!map) {
+		munmap(data, (size_t)st.st_size);
+		close(fd);
+		return 0;
+	}
+	map->data = (char*)data;
+	map->len = (uint64_t)st.st_size;
+	map->fd = fd;
+	*out = map;
+	return 1;
+}
+
+void ReplayMap_close(ReplayMap *map) {
+	if (map) {
+		if (map->data) munmap(map->data, (size_t)map->len);
+		close(map->fd);
+		free(map);
+	}
+}
+
+void ReplayMap_prefetch(ReplayMap *map, uint64_t offset, uint64_t len) {
+	if (!map || offset >= map->len) return;
+	uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t start = offset - (offset % page); // madvise requires a page aligned address
+	if (len > map->len - offset) len = map->len - offset;
+	madvise(map->data + start, (size_t)(offset + len - start), MADV_WILLNEED);
+}
+#else
+int ReplayMap_open(const char *path, ReplayMap **out) {
+	if (!path || !out) return 0;
+	// FILE_FLAG_SEQUENTIAL_SCAN only affects reads through the handle, page faults on the view are not read ahead.
+	// That's what ReplayMap_prefetch is for
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: Failed to open %s\n", path);
+		return 0;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: %s is empty or can't be examined\n", path);
+		CloseHandle(file);
+		return 0;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void *data = (mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL);
+	if (!data) {
+		fl2k433_fprintf(stderr, "ReplayMap_open: Failed to map %s\n", path);
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return 0;
+	}
+
+	ReplayMap *map = (ReplayMap*)calloc(1, sizeof(ReplayMap));
+	if (!map) {
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return 0;
+	}
+	map->data = (char*)data;
+	map->len = (uint64_t)size.QuadPart;
+	map->file = file;
+	map->mapping = mapping;
+	*out = map;
+	return 1;
+}
+
+void ReplayMap_close(ReplayMap *map) {
+	if (map) {
+		if (map->data) UnmapViewOfFile(map->data);
+		if (map->mapping) CloseHandle((HANDLE)map->mapping);
+		if (map->file) CloseHandle((HANDLE)map->file);
+		free(map);
+	}
+}
+
+// PrefetchVirtualMemory is available since Windows 8. It's looked up at run time, so the library still loads on older versions
+// (which get no read ahead)
+typedef struct _ReplayRange {	// same layout as WIN32_MEMORY_RANGE_ENTRY
+	PVOID VirtualAddress;
+	SIZE_T NumberOfBytes;
+} ReplayRange;
+typedef BOOL(WINAPI *PrefetchVirtualMemoryFn)(HANDLE process, ULONG_PTR n_entries, ReplayRange *entries, ULONG flags);
+
+void ReplayMap_prefetch(ReplayMap *map, uint64_t offset, uint64_t len) {
+	static PrefetchVirtualMemoryFn volatile prefetch = NULL;
+	static volatile LONG resolved = 0; // racing threads resolve the same address
+	if (!resolved) {
+		HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+		prefetch = (kernel32 ? (PrefetchVirtualMemoryFn)GetProcAddress(kernel32, "PrefetchVirtualMemory") : NULL);
+		resolved = 1;
+	}
+	if (!map || offset >= map->len || !prefetch) return;
+	if (len > map->len - offset) len = map->len - offset;
+	ReplayRange range;
+	range.VirtualAddress = map->data + offset;
+	range.NumberOfBytes = (SIZE_T)len;
+	prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+#endif
+
+int ReplayMap_parseName(const char *path, int *mod, uint32_t *samp_rate, uint32_t *carrier1, uint32_t *carrier2) {
+	if (!path) return 0;
+	const char *fname = path;
+	for (const char *p = path; *p; p++) {
+		if (*p == '/' || *p == '\\') fname = p + 1;
+	}
+
+	unsigned int s, c1, c2 = 0, num;
+	if (sscanf(fname, "OOK_s%u_c%u_%u.bin", &s, &c1, &num) == 3) *mod = MODULATION_TYPE_OOK;
+	else if (sscanf(fname, "FSK_s%u_cp%u_cs%u_%u.bin", &s, &c1, &c2, &num) == 4) *mod = MODULATION_TYPE_FSK;
+	else if (sscanf(fname, "RAW_s%u_cp%u_cs%u_%u.bin", &s, &c1, &c2, &num) == 4) *mod = MODULATION_TYPE_RAW;
+	else return 0;
+	*samp_rate = s;
+	*carrier1 = c1;
+	*carrier2 = c2;
+	return 1;
+}
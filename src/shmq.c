@@ -0,0 +1,281 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <errno.h>
+#ifdef __linux__
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+#else
+#include <windows.h>
+#endif
+
+#include "shmq.h"
+#include "shmq_daemon.h"
+#include "redir_print.h"
+
+#define SLOT(q, ticket) ((ShmqSlot*)&(q)->slots[(uint64_t)((ticket) % (q)->n_slots) * (q)->slot_size])
+
+static int cas32(volatile uint32_t *p, uint32_t expected, uint32_t desired) {
+#ifdef _WIN32
+	return ((uint32_t)InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)expected) == expected);
+#else
+	return __sync_bool_compare_and_swap(p, expected, desired);
+#endif
+}
+
+static void inc32(volatile uint32_t *p) {
+#ifdef _WIN32
+	InterlockedIncrement((volatile LONG*)p);
+#else
+	__sync_add_and_fetch(p, 1);
+#endif
+}
+
+static void barrier(void) {
+#ifdef _WIN32
+	MemoryBarrier();
+#else
+	__sync_synchronize();
+#endif
+}
+
+// Sleeps until the doorbell differs from seen (or the timeout elapsed)
+static void doorbell_wait(Shmq *q, uint32_t seen, uint32_t timeout_ms) {
+#if defined(_WIN32)
+	(void)seen;
+	WaitForSingleObject((HANDLE)q->event, timeout_ms);
+#elif defined(__linux__)
+	struct timespec ts;
+	ts.tv_sec = timeout_ms / 1000;
+	ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+	syscall(SYS_futex, &q->hdr->doorbell, FUTEX_WAIT, seen, &ts, NULL, 0); // shared (non private) futex: works across processes
+#else
+	(void)seen; (void)timeout_ms;
+	usleep(1000); // no cross-process wait primitive, poll
+#endif
+}
+
+static void doorbell_ring(Shmq *q) {
+	inc32(&q->hdr->doorbell);
+	barrier();
+	if (!q->hdr->waiting) return; // the daemon is busy and will see the slot without being woken up
+#if defined(_WIN32)
+	SetEvent((HANDLE)q->event);
+#elif defined(__linux__)
+	syscall(SYS_futex, &q->hdr->doorbell, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+static Shmq *Shmq_map(const char *name, int owner, uint64_t size) {
+	if (!name || strlen(name) > 40) {
+		fl2k433_fprintf(stderr, "Shmq: Missing or too long name.\n");
+		return NULL;
+	}
+	Shmq *q = (Shmq*)calloc(1, sizeof(Shmq));
+	if (!q) return NULL;
+	q->owner = owner;
+	void *mem = NULL;
+#ifndef _WIN32
+	snprintf(q->name, sizeof(q->name), "/fl2k433_%s", name);
+	q->lock_fd = -1;
+	int fd = shm_open(q->name, (owner ? O_CREAT | O_RDWR : O_RDWR), 0666);
+	if (fd >= 0 && owner) {
+		// the daemon holds an exclusive lock on the object while it lives (released by the kernel if it dies)
+		if (flock(fd, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK) {
+			fl2k433_fprintf(stderr, "Shmq: %s is served by another daemon\n", q->name);
+			close(fd);
+			free(q);
+			return NULL;
+		}
+		// leftovers of a daemon that died are cleared (truncated) before the object gets its new size
+		if (ftruncate(fd, 0) != 0 || ftruncate(fd, (off_t)size) != 0) size = 0;
+	}
+	if (fd >= 0) {
+		struct stat st;
+		if (!owner) size = (fstat(fd, &st) == 0 ? (uint64_t)st.st_size : 0);
+		if (size >= sizeof(ShmqHeader)) {
+			mem = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mem == MAP_FAILED) mem = NULL;
+		}
+		if (mem && owner) q->lock_fd = fd; // keeps the lock
+		else close(fd);
+	}
+	if (!mem && owner && fd >= 0) shm_unlink(q->name);
+#else
+	char evname[80];
+	snprintf(q->name, sizeof(q->name), "Local\\fl2k433_%s", name);
+	snprintf(evname, sizeof(evname), "%s_bell", q->name);
+	if (owner) {
+		q->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, q->name);
+		if (q->mapping && GetLastError() == ERROR_ALREADY_EXISTS) { // the mapping lives as long as a daemon or client holds it
+			fl2k433_fprintf(stderr, "Shmq: %s is served by another daemon (or still open in a client)\n", q->name);
+			CloseHandle((HANDLE)q->mapping);
+			free(q);
+			return NULL;
+		}
+		q->event = CreateEventA(NULL, FALSE, FALSE, evname);
+	}
+	else {
+		q->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, q->name);
+		q->event = OpenEventA(EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, evname);
+	}
+	if (q->mapping && q->event) {
+		mem = MapViewOfFile((HANDLE)q->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+		if (mem && !owner) {
+			MEMORY_BASIC_INFORMATION mbi;
+			size = (VirtualQuery(mem, &mbi, sizeof(mbi)) ? (uint64_t)mbi.RegionSize : 0);
+		}
+	}
+	if (!mem) {
+		if (q->mapping) CloseHandle((HANDLE)q->mapping);
+		if (q->event) CloseHandle((HANDLE)q->event);
+	}
+#endif
+	if (!mem) {
+		fl2k433_fprintf(stderr, "Shmq: Failed to %s shared memory %s\n", (owner ? "create" : "open"), q->name);
+		free(q);
+		return NULL;
+	}
+	q->hdr = (ShmqHeader*)mem;
+	q->size = size;
+	return q;
+}
+
+Shmq *Shmq_create(const char *name, uint32_t n_slots, uint32_t slot_len) {
+	if (!n_slots || !slot_len) return NULL;
+	uint32_t slot_size = (SHMQ_SLOT_HDR_LEN + slot_len + 63) & ~63u; // keep slots on separate cache lines
+	uint64_t hdr_size = (sizeof(ShmqHeader) + 63) & ~(uint64_t)63;
+	Shmq *q = Shmq_map(name, 1, hdr_size + (uint64_t)n_slots * slot_size);
+	if (!q) return NULL;
+	memset(q->hdr, 0, (size_t)hdr_size);
+	q->hdr->version = SHMQ_VERSION;
+	q->hdr->n_slots = n_slots;
+	q->hdr->slot_len = slot_len;
+	q->hdr->slot_size = slot_size;
+	q->n_slots = n_slots;
+	q->slot_len = slot_len;
+	q->slot_size = slot_size;
+	q->tail = 0;
+	q->slots = (char*)q->hdr + hdr_size;
+	for (uint32_t a = 0; a < n_slots; a++) SLOT(q, a)->seq = 0;
+	barrier();
+	q->hdr->magic = SHMQ_MAGIC; // clients may connect from now on
+	return q;
+}
+
+static void Shmq_unmap(Shmq *q) {
+#ifndef _WIN32
+	munmap(q->hdr, (size_t)q->size);
+	if (q->owner) shm_unlink(q->name);
+	if (q->lock_fd >= 0) close(q->lock_fd); // releases the lock
+#else
+	UnmapViewOfFile(q->hdr);
+	CloseHandle((HANDLE)q->mapping);
+	CloseHandle((HANDLE)q->event);
+#endif
+	free(q);
+}
+
+void Shmq_destroy(Shmq *q) {
+	if (q) Shmq_unmap(q);
+}
+
+int Shmq_next(Shmq *q, ShmqSlot *slot, char **payload, uint32_t timeout_ms) {
+	uint32_t t = q->tail;
+	ShmqSlot *s = SLOT(q, t);
+	if (s->seq != t + 1) {
+		uint32_t seen = q->hdr->doorbell;
+		q->hdr->waiting = 1;
+		barrier();
+		if (s->seq != t + 1) doorbell_wait(q, seen, timeout_ms); // re-check: a commit may have slipped in before waiting was set
+		q->hdr->waiting = 0;
+		if (s->seq != t + 1) return 0;
+	}
+	barrier(); // read the slot contents only after its sequence number
+	slot->seq = s->seq;
+	slot->mod = s->mod;
+	slot->samp_rate = s->samp_rate;
+	slot->len = s->len;
+	slot->gap = s->gap;
+	*payload = (char*)s + SHMQ_SLOT_HDR_LEN;
+	return 1;
+}
+
+void Shmq_release(Shmq *q) {
+	barrier(); // finish reading the slot before clients may reuse it
+	q->tail++;
+	q->hdr->tail = q->tail;
+}
+
+FL2K_433_API Shmq *Shmq_connect(const char *name) {
+	Shmq *q = Shmq_map(name, 0, 0);
+	if (!q) return NULL;
+	if (q->hdr->magic != SHMQ_MAGIC || q->hdr->version != SHMQ_VERSION) {
+		fl2k433_fprintf(stderr, "Shmq_connect: %s is not (yet) a compatible fl2k_433 ring.\n", q->name);
+		Shmq_unmap(q);
+		return NULL;
+	}
+	uint64_t hdr_size = (sizeof(ShmqHeader) + 63) & ~(uint64_t)63;
+	q->n_slots = q->hdr->n_slots;
+	q->slot_len = q->hdr->slot_len;
+	q->slot_size = q->hdr->slot_size;
+	if (!q->n_slots || q->slot_size < SHMQ_SLOT_HDR_LEN + (uint64_t)q->slot_len || hdr_size + (uint64_t)q->n_slots * q->slot_size > q->size) {
+		fl2k433_fprintf(stderr, "Shmq_connect: %s has an inconsistent layout.\n", q->name);
+		Shmq_unmap(q);
+		return NULL;
+	}
+	q->slots = (char*)q->hdr + hdr_size;
+	return q;
+}
+
+FL2K_433_API void Shmq_disconnect(Shmq *q) {
+	if (q && !q->owner) Shmq_unmap(q);
+}
+
+FL2K_433_API char *Shmq_reserve(Shmq *q, uint32_t len, uint32_t *ticket) {
+	if (!q || !ticket || len > q->slot_len) return NULL;
+	uint32_t h;
+	do {
+		h = q->hdr->head;
+		if (h - q->hdr->tail >= q->n_slots) return NULL; // ring is full
+	} while (!cas32(&q->hdr->head, h, h + 1));
+	*ticket = h;
+	return (char*)SLOT(q, h) + SHMQ_SLOT_HDR_LEN;
+}
+
+FL2K_433_API int Shmq_commit(Shmq *q, uint32_t ticket, int mod, uint32_t samp_rate, uint32_t len, uint32_t gap) {
+	if (!q || len > q->slot_len) return -1;
+	ShmqSlot *s = SLOT(q, ticket);
+	s->mod = mod;
+	s->samp_rate = samp_rate;
+	s->len = len;
+	s->gap = gap;
+	barrier(); // publish contents before the sequence number
+	s->seq = ticket + 1;
+	doorbell_ring(q);
+	return 0;
+}
@@ -1,26 +1,16 @@
-#define _USE_MATH_DEFINES
-#include <math.h>
-
 #include "sinegen.h"
+#include <string.h>
 #include "malloc.h"
 
 int SineGen_init(SineGen **sg_out){
 	if (sg_out) {
 		SineGen *sg = (SineGen*)malloc(sizeof(SineGen));
 		if (sg) {
-			sg->sine_curve = (char*)malloc(REFSINE_RESOLUTION);
-			if (sg->sine_curve) {
-				for (int a = 0; a < REFSINE_RESOLUTION; a++) {
-					double current_radian = (double)a / (double)REFSINE_RESOLUTION;
-					sg->sine_curve[a] = (char)(127.0 * sin(2 * current_radian*M_PI));
-				}
-				sg->sine_step = 0.0;
-				sg->pos_startidx = 0;
-				sg->pos_numsteps = 0;
-				*sg_out = sg;
-				return 1;
-			}
-			free(sg);
+			sg->sine_step = 0.0;
+			sg->pos_startidx = 0;
+			sg->pos_numsteps = 0;
+			*sg_out = sg;
+			return 1;
 		}
 	}
 	return 0;
@@ -28,7 +18,6 @@ int SineGen_init(SineGen **sg_out){
 
 void SineGen_destroy(SineGen *sg) {
 	if (sg) {
-		if (sg->sine_curve) free(sg->sine_curve);
 		free(sg);
 	}
 }
@@ -44,9 +33,27 @@ void SineGen_configure(SineGen *sg, unsigned long samp_rate, unsigned long freq)
 
 char SineGen_getSample(SineGen *sg){
 	char smp = 0;
-	if (sg && sg->sine_curve) {
+	if (sg) {
 		unsigned long long idx = ((unsigned long long) sg->pos_startidx + (unsigned long long)(sg->pos_numsteps++ * sg->sine_step));
-		smp = sg->sine_curve[idx % REFSINE_RESOLUTION];
+		smp = SineGen_lookup(idx);
 	}
 	return smp;
 }
+
+void SineGen_fill(SineGen *sg, char *out, unsigned long n) {
+	if (!sg) return;
+	if (sg->sine_step == 0.0) { // 0 MHz: constant level
+		memset(out, SineGen_lookup(sg->pos_startidx), n);
+	}
+	else {
+		// same index as SineGen_getSample. The step count is kept as a double (exact below 2^53) and the product is converted
+		// through a signed integer (never negative), both conversions are single instructions unlike their unsigned forms
+		unsigned long long startidx = sg->pos_startidx;
+		double numsteps = (double)sg->pos_numsteps;
+		double step = sg->sine_step;
+		for (unsigned long a = 0; a < n; a++, numsteps += 1.0) {
+			out[a] = SineGen_lookup(startidx + (unsigned long long)(long long)(numsteps * step));
+		}
+	}
+	sg->pos_numsteps += n;
+}
@@ -0,0 +1,312 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#ifndef _WIN32
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#else
+#include <windows.h>
+#endif
+
+#include "tpool.h"
+#include "redir_print.h"
+
+typedef struct _TpoolJob {
+	TpoolWorkFn fn;
+	void *ctx;
+	const TpoolSched *sched;
+	uint32_t n;
+	volatile long next;	// next index to be handed out
+} TpoolJob;
+
+static long fetch_next(TpoolJob *job) {
+#ifdef _WIN32
+	return InterlockedIncrement(&job->next) - 1;
+#else
+	return __sync_fetch_and_add(&job->next, 1);
+#endif
+}
+
+static void run_job(TpoolJob *job) {
+	long idx;
+	if (job->sched) Tpool_applySched(job->sched, "render thread");
+	while ((idx = fetch_next(job)) < (long)job->n) {
+		job->fn(job->ctx, (uint32_t)idx);
+	}
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker(LPVOID arg) {
+	run_job((TpoolJob*)arg);
+	return 0;
+}
+#else
+static void *worker(void *arg) {
+	run_job((TpoolJob*)arg);
+	return NULL;
+}
+#endif
+
+uint32_t Tpool_numCores(void) {
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1);
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0 ? (uint32_t)n : 1);
+#endif
+}
+
+uint32_t Tpool_parallelFor(uint32_t n, uint32_t nthreads, TpoolWorkFn fn, void *ctx, const TpoolSched *sched) {
+	TpoolJob job;
+	job.fn = fn;
+	job.ctx = ctx;
+	job.sched = sched;
+	job.n = n;
+	job.next = 0;
+	uint32_t first = (sched ? 0 : 1); // number of threads not to be created (the calling one helps out if it may)
+
+	if (!nthreads) nthreads = Tpool_numCores();
+	if (nthreads > n) nthreads = n;
+	if (nthreads > TPOOL_MAX_THREADS) nthreads = TPOOL_MAX_THREADS;
+
+	// start helper threads. If some of them can't be created, the remaining ones just take over their share
+	uint32_t started = 0;
+#ifdef _WIN32
+	HANDLE threads[TPOOL_MAX_THREADS];
+	for (uint32_t a = first; a < nthreads; a++) {
+		threads[started] = CreateThread(NULL, 0, worker, &job, 0, NULL);
+		if (threads[started]) started++;
+	}
+	if (!sched || !started) run_job(&job);
+	for (uint32_t a = 0; a < started; a++) {
+		WaitForSingleObject(threads[a], INFINITE);
+		CloseHandle(threads[a]);
+	}
+#else
+	pthread_t threads[TPOOL_MAX_THREADS];
+	for (uint32_t a = first; a < nthreads; a++) {
+		if (pthread_create(&threads[started], NULL, worker, &job) == 0) started++;
+	}
+	if (!sched || !started) run_job(&job);
+	for (uint32_t a = 0; a < started; a++) {
+		pthread_join(threads[a], NULL);
+	}
+#endif
+	return (sched && started ? started : started + 1);
+}
+
+int Tpool_applySched(const TpoolSched *sched, const char *who) {
+	int failed = 0;
+	if (!sched) return failed;
+#ifdef _WIN32
+	if (sched->cpu_affinity && !SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)sched->cpu_affinity)) {
+		fl2k433_fprintf(stderr, "%s: Failed to set CPU affinity (error %lu).\n", who, GetLastError());
+		failed++;
+	}
+	if (sched->rt_priority > 0 && !SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+		fl2k433_fprintf(stderr, "%s: Failed to raise thread priority (error %lu).\n", who, GetLastError());
+		failed++;
+	}
+#else
+	if (sched->cpu_affinity) {
+#ifdef __linux__
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int a = 0; a < 64 && a < CPU_SETSIZE; a++) {
+			if (sched->cpu_affinity & ((uint64_t)1 << a)) CPU_SET(a, &set);
+		}
+		int r = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (r != 0) {
+			fl2k433_fprintf(stderr, "%s: Failed to set CPU affinity: %s\n", who, strerror(r));
+			failed++;
+		}
+#else
+		fl2k433_fprintf(stderr, "%s: CPU affinity is not supported on this platform.\n", who);
+		failed++;
+#endif
+	}
+	if (sched->rt_priority > 0) {
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = sched->rt_priority;
+		int r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (r != 0) {
+			fl2k433_fprintf(stderr, "%s: Failed to set SCHED_FIFO priority %ld: %s\n", who, (long)sched->rt_priority, strerror(r));
+			failed++;
+		}
+	}
+#endif
+	return failed;
+}
+
+#ifdef _WIN32
+static SRWLOCK ws_lock = SRWLOCK_INIT; // serializes the read-modify-write of the working set size
+
+// Grows (grow > 0) or shrinks the working set limits by len. The working set has to be large enough to hold all locked ranges
+static void AdjustWorkingSet(size_t len, int grow) {
+	SIZE_T min_ws, max_ws;
+	AcquireSRWLockExclusive(&ws_lock);
+	if (GetProcessWorkingSetSize(GetCurrentProcess(), &min_ws, &max_ws)) {
+		if (grow) SetProcessWorkingSetSize(GetCurrentProcess(), min_ws + len, max_ws + len);
+		else if (min_ws > len) SetProcessWorkingSetSize(GetCurrentProcess(), min_ws - len, max_ws - len);
+	}
+	ReleaseSRWLockExclusive(&ws_lock);
+}
+#endif
+
+int Tpool_lockMemory(void *addr, size_t len) {
+#ifdef _WIN32
+	AdjustWorkingSet(len, 1);
+	if (!VirtualLock(addr, len)) {
+		fl2k433_fprintf(stderr, "Tpool_lockMemory: Failed to lock memory (error %lu).\n", GetLastError());
+		AdjustWorkingSet(len, 0);
+		return 0;
+	}
+#else
+	if (mlock(addr, len) != 0) { // Linux rounds the range to whole pages itself
+		fl2k433_fprintf(stderr, "Tpool_lockMemory: mlock failed: %s\n", strerror(errno));
+		return 0;
+	}
+#endif
+	return 1;
+}
+
+// Only pass ranges that were locked successfully (Windows: gives back the working set they were granted)
+void Tpool_unlockMemory(void *addr, size_t len) {
+#ifdef _WIN32
+	VirtualUnlock(addr, len);
+	AdjustWorkingSet(len, 0);
+#else
+	munlock(addr, len);
+#endif
+}
+
+struct _TpoolThread {
+	void(*fn)(void *ctx);
+	void *ctx;
+	const TpoolSched *sched;
+	TpoolSched sched_copy;
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+#ifdef _WIN32
+static DWORD WINAPI thread_main(LPVOID arg) {
+#else
+static void *thread_main(void *arg) {
+#endif
+	TpoolThread *thread = (TpoolThread*)arg;
+	if (thread->sched) Tpool_applySched(thread->sched, "library thread");
+	thread->fn(thread->ctx);
+	return 0;
+}
+
+TpoolThread *Tpool_threadStart(void(*fn)(void *ctx), void *ctx, const TpoolSched *sched) {
+	TpoolThread *thread = (TpoolThread*)calloc(1, sizeof(TpoolThread));
+	if (!thread) return NULL;
+	thread->fn = fn;
+	thread->ctx = ctx;
+	if (sched) {
+		thread->sched_copy = *sched;
+		thread->sched = &thread->sched_copy;
+	}
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+	if (!thread->handle) {
+#else
+	if (pthread_create(&thread->handle, NULL, thread_main, thread) != 0) {
+#endif
+		free(thread);
+		return NULL;
+	}
+	return thread;
+}
+
+void Tpool_threadJoin(TpoolThread *thread) {
+	if (!thread) return;
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+	free(thread);
+}
+
+struct _TpoolMutex {
+#ifdef _WIN32
+	CRITICAL_SECTION cs;
+#else
+	pthread_mutex_t mtx;
+#endif
+};
+
+TpoolMutex *Tpool_mutexCreate(void) {
+	TpoolMutex *mtx = (TpoolMutex*)malloc(sizeof(TpoolMutex));
+	if (mtx) {
+#ifdef _WIN32
+		InitializeCriticalSection(&mtx->cs);
+#else
+		if (pthread_mutex_init(&mtx->mtx, NULL) != 0) {
+			free(mtx);
+			return NULL;
+		}
+#endif
+	}
+	return mtx;
+}
+
+void Tpool_mutexDestroy(TpoolMutex *mtx) {
+	if (mtx) {
+#ifdef _WIN32
+		DeleteCriticalSection(&mtx->cs);
+#else
+		pthread_mutex_destroy(&mtx->mtx);
+#endif
+		free(mtx);
+	}
+}
+
+void Tpool_mutexLock(TpoolMutex *mtx) {
+#ifdef _WIN32
+	EnterCriticalSection(&mtx->cs);
+#else
+	pthread_mutex_lock(&mtx->mtx);
+#endif
+}
+
+void Tpool_mutexUnlock(TpoolMutex *mtx) {
+#ifdef _WIN32
+	LeaveCriticalSection(&mtx->cs);
+#else
+	pthread_mutex_unlock(&mtx->mtx);
+#endif
+}
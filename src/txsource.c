@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "txsource.h"
+#include "redir_print.h"
+
+static uint32_t file_read(void *ctx, char *buf, uint32_t len) {
+	return (uint32_t)fread(buf, 1, len, (FILE*)ctx);
+}
+
+static void file_close(void *ctx) {
+	fclose((FILE*)ctx);
+}
+
+FL2K_433_API TxSource *TxSource_openGenerator(TxSourceReadFn gen, TxSourceCloseFn close, void *ctx, int mod, uint32_t samp_rate) {
+	if (!gen || !samp_rate) {
+		fl2k433_fprintf(stderr, "TxSource_openGenerator: mandatory parameter is not set.\n");
+		return NULL;
+	}
+	TxSource *src = (TxSource*)calloc(1, sizeof(TxSource));
+	if (src) {
+		src->chunk = (char*)malloc(TXSOURCE_CHUNK_LEN);
+		if (src->chunk) {
+			src->mod = mod;
+			src->samp_rate = samp_rate;
+			src->read = gen;
+			src->close = close;
+			src->ctx = ctx;
+			return src;
+		}
+		free(src);
+	}
+	fl2k433_fprintf(stderr, "TxSource_openGenerator: out of memory.\n");
+	return NULL;
+}
+
+FL2K_433_API TxSource *TxSource_openFile(const char *path, int mod, uint32_t samp_rate) {
+	if (!path) {
+		fl2k433_fprintf(stderr, "TxSource_openFile: mandatory parameter is not set.\n");
+		return NULL;
+	}
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		fl2k433_fprintf(stderr, "TxSource_openFile: Failed to open %s\n", path);
+		return NULL;
+	}
+	TxSource *src = TxSource_openGenerator(file_read, file_close, f, mod, samp_rate);
+	if (!src) fclose(f);
+	return src;
+}
+
+FL2K_433_API void TxSource_destroy(TxSource *src) {
+	if (src) {
+		if (src->close) src->close(src->ctx);
+		if (src->chunk) free(src->chunk);
+		free(src);
+	}
+}
+
+// Sample-and-hold resampling: output sample k carries input sample floor(k * in_rate / out_rate)
+uint32_t TxSource_render(TxSource *src, char *out, uint32_t out_len, uint32_t out_rate) {
+	uint32_t n = 0;
+	if (!src || !out || !out_rate) return n;
+	if (src->in_frac >= out_rate) src->in_frac = 0; // output rate was lowered since the last call
+	while (n < out_len) {
+		// pull the next chunk if the required input sample isn't in the current one
+		while (src->in_idx >= src->chunk_base + src->chunk_len) {
+			if (src->eof) return n;
+			src->chunk_base += src->chunk_len;
+			src->chunk_len = src->read(src->ctx, src->chunk, TXSOURCE_CHUNK_LEN);
+			if (!src->chunk_len) {
+				src->eof = 1;
+				return n;
+			}
+		}
+		out[n++] = src->chunk[src->in_idx - src->chunk_base];
+		src->in_frac += src->samp_rate;
+		while (src->in_frac >= out_rate) {
+			src->in_frac -= out_rate;
+			src->in_idx++;
+		}
+	}
+	return n;
+}
@@ -0,0 +1,453 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include "libfl2k_433.h"
+#include "redir_print.h"
+#include "stubdev.h"
+
+#define VERIFY_RUN_MARGIN 64	// output samples next to a symbol edge that are left out of frequency measurements
+#define VERIFY_PHASE_GUARD 2	// output samples next to a symbol edge that are left out of phase measurements
+#define VERIFY_PHASE_LEN 512	// max. output samples used to measure the phase on each side of a symbol edge
+
+// Test message: one PRBS7 bit (x^7 + x^6 + 1) per symbol
+static void MakeTestSignal(char *sig, uint32_t n_symbols) {
+	uint8_t lfsr = 0x7F;
+	for (uint32_t s = 0; s < n_symbols; s++) {
+		uint8_t bit = ((lfsr >> 6) ^ (lfsr >> 5)) & 1;
+		lfsr = ((lfsr << 1) | bit) & 0x7F;
+		memset(&sig[s * VERIFY_SYMBOL_LEN], bit, VERIFY_SYMBOL_LEN);
+	}
+}
+
+// Pulls n_bufs buffers of the queued test message from the stub device. Returns the samples (to be freed) or NULL
+static char *RenderTest(fl2k_433_t *tmp, uint32_t n_bufs, VerifyReport *rep) {
+	char *out = (char*)malloc((size_t)n_bufs * FL2K_BUF_LEN);
+	if (!out) return NULL;
+	uint64_t total_us = 0;
+	for (uint32_t b = 0; b < n_bufs; b++) {
+		uint64_t us;
+		char *buf = StubDevice_pull(tmp, &us);
+		if (!buf) {
+			free(out);
+			return NULL;
+		}
+		memcpy(&out[(size_t)b * FL2K_BUF_LEN], buf, FL2K_BUF_LEN);
+		total_us += us;
+	}
+	rep->n_samples = (uint64_t)n_bufs * FL2K_BUF_LEN;
+	rep->samples_per_sec = (total_us ? (double)rep->n_samples * 1000000.0 / (double)total_us : 0.0);
+	return out;
+}
+
+// Position of the rising zero crossing between x[k - 1] and x[k] (linear interpolation), or -1
+static double Crossing(const char *x, int64_t k) {
+	if (x[k - 1] >= 0 || x[k] < 0) return -1.0;
+	return (double)(k - 1) + (double)(-x[k - 1]) / (double)(x[k] - x[k - 1]);
+}
+
+// Collects the rising zero crossings within x[a..b). Returns their number (at most t_max)
+static uint32_t Crossings(const char *x, int64_t a, int64_t b, double *t, uint32_t t_max) {
+	uint32_t n = 0;
+	for (int64_t k = a + 1; k < b && n < t_max; k++) {
+		double c = Crossing(x, k);
+		if (c >= 0.0) t[n++] = c;
+	}
+	return n;
+}
+
+// Adds the full cycles within x[a..b) and their duration (samples) to *cycles and *dur
+static void MeasureFreq(const char *x, int64_t a, int64_t b, double *cycles, double *dur) {
+	double first = -1.0, last = -1.0;
+	uint32_t n = 0;
+	for (int64_t k = a + 1; k < b; k++) {
+		double c = Crossing(x, k);
+		if (c < 0.0) continue;
+		if (first < 0.0) first = c;
+		last = c;
+		n++;
+	}
+	if (n < 2) return;
+	*cycles += n - 1;
+	*dur += last - first;
+}
+
+// Phase (rad) at sample ref of the sine with frequency freq contained in x[a..b). Hann weighted, so the mirror frequency doesn't leak in
+static double PhaseAt(const char *x, int64_t a, int64_t b, double freq, double fs, double ref) {
+	double w = 2.0 * M_PI * freq / fs;
+	double re = 0.0, im = 0.0;
+	for (int64_t k = a; k < b; k++) {
+		double v = x[k] * (0.5 - 0.5 * cos(2.0 * M_PI * ((double)(k - a) + 0.5) / (double)(b - a)));
+		re += v * cos(w * ((double)k - ref));
+		im -= v * sin(w * ((double)k - ref));
+	}
+	return atan2(im, re) + M_PI / 2.0; // x[k] = A * sin(w * (k - ref) + phase)
+}
+
+// FSK: locates the switch from f_old to f_new within x[a..b) by the periods of the zero crossings.
+// Returns the edge position (fractional output samples) or -1
+static double FskEdge(const char *x, int64_t a, int64_t b, double f_old, double f_new, double fs, double *t, uint32_t t_max) {
+	double p_old = fs / f_old, p_new = fs / f_new;
+	uint32_t n = Crossings(x, a, b, t, t_max);
+	for (uint32_t j = 1; j + 2 < n; j++) {
+		if (fabs(t[j + 1] - t[j] - p_new) >= fabs(t[j + 1] - t[j] - p_old)) continue;
+		if (fabs(t[j + 2] - t[j + 1] - p_new) >= fabs(t[j + 2] - t[j + 1] - p_old)) continue;
+		// The switch lies in interval j - 1 or j (the last old or the first new looking one). Within an interval [t0, t1]
+		// containing it: (tau - t0) / p_old + (t1 - tau) / p_new = 1. A pure interval yields its boundary t[j]
+		double tau[2];
+		for (uint32_t c = 0; c < 2; c++) {
+			double t0 = t[j - 1 + c], t1 = t[j + c];
+			double s = (1.0 - t1 / p_new + t0 / p_old) / (1.0 / p_old - 1.0 / p_new);
+			tau[c] = (s < t0 ? t0 : (s > t1 ? t1 : s));
+		}
+		return (fabs(tau[0] - t[j]) > fabs(tau[1] - t[j]) ? tau[0] : tau[1]);
+	}
+	return -1.0;
+}
+
+// OOK: locates the edge within x[a..b) where the carrier starts (rising) or stops (falling). 0 MHz is a constant level.
+// Returns the index of the first sample of the new symbol or -1
+static int64_t OokEdge(const char *x, int64_t a, int64_t b, int rising) {
+	int64_t edge = -1;
+	for (int64_t k = a + 1; k < b; k++) {
+		if (x[k] == x[k - 1]) continue;
+		if (rising) return k - 1; // the carrier starts at the level held during the pause
+		edge = k; // the pause holds the level the carrier would have had next
+	}
+	return edge;
+}
+
+// In-place radix-2 FFT (n = power of 2)
+static void Fft(double *re, double *im, uint32_t n) {
+	for (uint32_t i = 1, j = 0; i < n; i++) { // bit reversal permutation
+		uint32_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) j ^= bit;
+		j ^= bit;
+		if (i < j) {
+			double tr = re[i], ti = im[i];
+			re[i] = re[j]; im[i] = im[j];
+			re[j] = tr; im[j] = ti;
+		}
+	}
+	for (uint32_t len = 2; len <= n; len <<= 1) {
+		double wr = cos(-2.0 * M_PI / len), wi = sin(-2.0 * M_PI / len);
+		for (uint32_t i = 0; i < n; i += len) {
+			double cr = 1.0, ci = 0.0;
+			for (uint32_t k = 0; k < len / 2; k++) {
+				uint32_t p = i + k, q = i + k + len / 2;
+				double tr = re[q] * cr - im[q] * ci, ti = re[q] * ci + im[q] * cr;
+				re[q] = re[p] - tr; im[q] = im[p] - ti;
+				re[p] += tr; im[p] += ti;
+				double nr = cr * wr - ci * wi;
+				ci = cr * wi + ci * wr;
+				cr = nr;
+			}
+		}
+	}
+}
+
+// SINE: strongest spur next to the carrier (Hann windowed spectrum of the first VERIFY_FFT_LEN samples)
+static int MeasureSpurs(const char *x, double fs, double fc, VerifyReport *rep) {
+	const uint32_t n = VERIFY_FFT_LEN;
+	double *re = (double*)malloc(n * sizeof(double));
+	double *im = (double*)calloc(n, sizeof(double));
+	if (!re || !im) {
+		free(re);
+		free(im);
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	for (uint32_t k = 0; k < n; k++) re[k] = x[k] * (0.5 - 0.5 * cos(2.0 * M_PI * k / n));
+	Fft(re, im, n);
+
+	double bin_hz = fs / n;
+	int64_t kc = (int64_t)(fc / bin_hz + 0.5), span = (int64_t)(VERIFY_SPUR_SPAN / bin_hz);
+	int64_t lo = (kc - span < 1 ? 1 : kc - span), hi = (kc + span > n / 2 - 1 ? n / 2 - 1 : kc + span);
+	double p_carrier = 0.0, p_spur = 0.0;
+	int64_t k_spur = -1;
+	for (int64_t k = lo; k <= hi; k++) {
+		double p = re[k] * re[k] + im[k] * im[k];
+		if (k >= kc - VERIFY_SPUR_GUARD && k <= kc + VERIFY_SPUR_GUARD) {
+			if (p > p_carrier) p_carrier = p;
+		}
+		else if (p > p_spur) {
+			p_spur = p;
+			k_spur = k;
+		}
+	}
+	if (p_carrier > 0.0 && k_spur >= 0) {
+		rep->spur_dbc = 10.0 * log10((p_spur > 0.0 ? p_spur : 1e-30) / p_carrier);
+		rep->spur_offset = (double)(k_spur - kc) * bin_hz;
+	}
+	free(re);
+	free(im);
+	return 0;
+}
+
+static int VerifySine(fl2k_433_t *tmp, VerifyReport *rep) {
+	TxMsg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.mod = MODULATION_TYPE_SINE;
+	int r = 0;
+	for (uint32_t b = 0; b < VERIFY_SINE_BUFS && r == 0; b++) r = QueueTxMsg(tmp, &msg); // a SINE message lasts one buffer
+	if (r != 0) return r;
+
+	char *x = RenderTest(tmp, VERIFY_SINE_BUFS, rep);
+	if (!x) return FL2K_433_ERROR_OUTOFMEM;
+	double fs = tmp->cfg.samp_rate, cycles = 0.0, dur = 0.0;
+	MeasureFreq(x, 0, (int64_t)rep->n_samples, &cycles, &dur);
+	if (dur > 0.0) rep->carrier1_err = cycles / dur * fs - tmp->cfg.carrier1;
+	r = MeasureSpurs(x, fs, tmp->cfg.carrier1, rep);
+	free(x);
+	return r;
+}
+
+static int VerifySymbols(fl2k_433_t *tmp, int mod, VerifyReport *rep) {
+	char *sig = (char*)malloc(VERIFY_NUM_SYMBOLS * VERIFY_SYMBOL_LEN);
+	if (!sig) return FL2K_433_ERROR_OUTOFMEM;
+	MakeTestSignal(sig, VERIFY_NUM_SYMBOLS);
+	TxMsg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.mod = mod;
+	msg.buf = sig;
+	msg.len = VERIFY_NUM_SYMBOLS * VERIFY_SYMBOL_LEN;
+	msg.samp_rate = VERIFY_IN_RATE;
+	int r = QueueTxMsg(tmp, &msg); // copies (resamples) the signal
+	if (r != 0) {
+		free(sig);
+		return r;
+	}
+
+	double fs = tmp->cfg.samp_rate, scale = fs / VERIFY_IN_RATE;
+	double f_hi = tmp->cfg.carrier1, f_lo = (mod == MODULATION_TYPE_FSK ? tmp->cfg.carrier2 : 0);
+	uint32_t n_bufs = (uint32_t)((double)msg.len * scale) / FL2K_BUF_LEN + 1;
+	int64_t half = (int64_t)(VERIFY_SYMBOL_LEN * scale / 2); // half a symbol (output samples)
+	double *t = (double*)malloc((size_t)(half + 2) * sizeof(double)); // zero crossings within one symbol
+	char *x = RenderTest(tmp, n_bufs, rep);
+	if (!t || !x) {
+		free(sig);
+		free(t);
+		free(x);
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+
+	// carrier frequencies, measured within the runs of equal symbols
+	double cycles[2] = { 0.0, 0.0 }, dur[2] = { 0.0, 0.0 };
+	for (uint32_t s0 = 0, s1; s0 < VERIFY_NUM_SYMBOLS; s0 = s1) {
+		for (s1 = s0 + 1; s1 < VERIFY_NUM_SYMBOLS && sig[s1 * VERIFY_SYMBOL_LEN] == sig[s0 * VERIFY_SYMBOL_LEN]; s1++);
+		int level = sig[s0 * VERIFY_SYMBOL_LEN];
+		MeasureFreq(x, (int64_t)(s0 * VERIFY_SYMBOL_LEN * scale) + VERIFY_RUN_MARGIN, (int64_t)(s1 * VERIFY_SYMBOL_LEN * scale) - VERIFY_RUN_MARGIN, &cycles[level], &dur[level]);
+	}
+	if (dur[1] > 0.0) rep->carrier1_err = cycles[1] / dur[1] * fs - f_hi;
+	if (f_lo > 0.0 && dur[0] > 0.0) rep->carrier2_err = cycles[0] / dur[0] * fs - f_lo;
+
+	// symbol edges: timing against the input signal, glitches and phase jumps
+	double f_max = (f_hi > f_lo ? f_hi : f_lo);
+	double step_max = 2.0 * SineGen_lookup(REFSINE_QUARTER) * sin(M_PI * (f_max / fs < 0.5 ? f_max / fs : 0.5)) + 1.0; // +1: quantization
+	int64_t phase_len = (half - VERIFY_PHASE_GUARD < VERIFY_PHASE_LEN ? half - VERIFY_PHASE_GUARD : VERIFY_PHASE_LEN);
+	double err_sum = 0.0;
+	for (uint32_t s = 1; s < VERIFY_NUM_SYMBOLS; s++) {
+		int level = sig[s * VERIFY_SYMBOL_LEN], prev = sig[(s - 1) * VERIFY_SYMBOL_LEN];
+		if (level == prev) continue;
+		double expected = s * VERIFY_SYMBOL_LEN * scale; // sample and hold: input sample i covers [i, i + 1) / VERIFY_IN_RATE
+		int64_t a = (int64_t)expected - half, b = (int64_t)expected + half;
+		double found;
+		if (f_lo > 0.0) found = FskEdge(x, a, b, (prev ? f_hi : f_lo), (level ? f_hi : f_lo), fs, t, (uint32_t)(half + 2));
+		else found = (double)OokEdge(x, a, b, level);
+		if (found < 0.0) continue; // not detectable (e.g. carrier above Nyquist)
+
+		int64_t edge = (int64_t)(found + 0.5);
+		double err = (found - expected) / fs * 1000000.0;
+		err_sum += err;
+		if (fabs(err) > rep->timing_err_max) rep->timing_err_max = fabs(err);
+		for (int64_t k = edge - 2; k <= edge + 2; k++) {
+			double jump = abs(x[k] - x[k - 1]) / step_max;
+			if (jump > rep->edge_jump) rep->edge_jump = jump;
+		}
+		if (f_lo > 0.0) { // both sides of the edge extrapolated to its position have to show the same phase
+			double before = PhaseAt(x, edge - VERIFY_PHASE_GUARD - phase_len, edge - VERIFY_PHASE_GUARD, (prev ? f_hi : f_lo), fs, (double)edge);
+			double after = PhaseAt(x, edge + VERIFY_PHASE_GUARD, edge + VERIFY_PHASE_GUARD + phase_len, (level ? f_hi : f_lo), fs, (double)edge);
+			double diff = fabs(atan2(sin(after - before), cos(after - before)));
+			if (diff > rep->phase_err) rep->phase_err = diff;
+		}
+		rep->n_edges++;
+	}
+	if (rep->n_edges) rep->timing_err_mean = err_sum / rep->n_edges;
+	free(sig);
+	free(t);
+	free(x);
+	return 0;
+}
+
+// Image of the carrier (k * samp_rate +- carrier) closest to the RF target
+static double RfImage(double fs, double fc, double target) {
+	double k = floor(target / fs), best = fc;
+	double cand[4] = { k * fs - fc, k * fs + fc, (k + 1) * fs - fc, (k + 1) * fs + fc };
+	for (int a = 0; a < 4; a++) {
+		if (cand[a] > 0.0 && fabs(cand[a] - target) < fabs(best - target)) best = cand[a];
+	}
+	return best;
+}
+
+static void PrintReport(VerifyReport *rep, uint32_t rf_target) {
+	const char *names[] = { "NONE", "OOK", "FSK", "SINE" };
+	fl2k433_fprintf(stdout, "VerifySynthesis: %s, %llu samples rendered at %.1f MS/s\n", names[rep->mod], (unsigned long long)rep->n_samples, rep->samples_per_sec / 1000000.0);
+	fl2k433_fprintf(stdout, "  carrier error: %.3f Hz (primary), %.3f Hz (secondary)\n", rep->carrier1_err, rep->carrier2_err);
+	if (rep->mod == MODULATION_TYPE_SINE) {
+		fl2k433_fprintf(stdout, "  strongest spur: %.1f dBc at %+.0f Hz\n", rep->spur_dbc, rep->spur_offset);
+	}
+	else {
+		fl2k433_fprintf(stdout, "  %lu symbol edges: timing error %.3f us mean, %.3f us max\n", rep->n_edges, rep->timing_err_mean, rep->timing_err_max);
+		fl2k433_fprintf(stdout, "  edge jump %.2f (of carrier step), phase error %.4f rad\n", rep->edge_jump, rep->phase_err);
+	}
+	if (rf_target) fl2k433_fprintf(stdout, "  RF image next to %lu Hz: %.0f Hz (%+.0f Hz off)\n", rf_target, rep->rf_image, rep->rf_image - (double)rf_target);
+}
+
+// Renders a test signal (SINE: continuous carrier, OOK/FSK: PRBS7 message) with the configuration of fl2k through a stub device
+// and measures it. rf_target (Hz, 0 = none) selects the image of the carrier to report, e.g. 433920000.
+// fl2k itself (queue, state) is left untouched. Returns 0 on success
+FL2K_433_API int VerifySynthesis(fl2k_433_t *fl2k, int mod, uint32_t rf_target, VerifyReport *rep) {
+	if (!fl2k || !rep || !fl2k->cfg.samp_rate || !fl2k->cfg.carrier1) {
+		fl2k433_fprintf(stderr, "VerifySynthesis: mandatory parameter is not set.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	if (mod != MODULATION_TYPE_SINE && mod != MODULATION_TYPE_OOK && mod != MODULATION_TYPE_FSK) {
+		fl2k433_fprintf(stderr, "VerifySynthesis: unsupported modulation type.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	memset(rep, 0, sizeof(VerifyReport));
+	rep->mod = mod;
+
+	fl2k_433_t *tmp = NULL;
+	fl2k_433_init(&tmp);
+	if (!tmp || !tmp->sg) {
+		if (tmp) fl2k_433_destroy(tmp);
+		fl2k433_fprintf(stderr, "VerifySynthesis: out of memory\n");
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	tmp->cfg = fl2k->cfg;
+	tmp->cfg.verbose = 0;
+	tmp->cfg.msg_align = FL2K_433_DEFAULT_MSG_ALIGN;
+
+	int r = (mod == MODULATION_TYPE_SINE ? VerifySine(tmp, rep) : VerifySymbols(tmp, mod, rep));
+	fl2k_433_destroy(tmp);
+	if (r != 0) {
+		fl2k433_fprintf(stderr, "VerifySynthesis: test signal could not be rendered (%d).\n", r);
+		return r;
+	}
+	if (rf_target) rep->rf_image = RfImage(fl2k->cfg.samp_rate, fl2k->cfg.carrier1, rf_target);
+	if (fl2k->cfg.verbose > 0) PrintReport(rep, rf_target);
+	return 0;
+}
+
+// One benchmark run: queues the test signal into a fresh instance and pulls BENCH_BUFS buffers, composed by the kernels or
+// (ref > 0) by the per-sample reference loop. Returns the speed (samples/s) or < 0
+static double BenchRun(int mod, TxMsg *msg, int ref) {
+	fl2k_433_t *tmp = NULL;
+	fl2k_433_init(&tmp);
+	if (!tmp || !tmp->sg) {
+		if (tmp) fl2k_433_destroy(tmp);
+		return FL2K_433_ERROR_OUTOFMEM;
+	}
+	tmp->cfg.verbose = 0;
+	tmp->cfg.samp_rate = BENCH_SAMP_RATE;
+	tmp->cfg.carrier1 = BENCH_CARRIER1;
+	tmp->cfg.carrier2 = (mod == MODULATION_TYPE_FSK ? BENCH_CARRIER2 : 0);
+	tmp->cfg.msg_align = FL2K_433_DEFAULT_MSG_ALIGN;
+	tmp->ref_render = ref;
+	int r = 0;
+	// not timed. A SINE message lasts one buffer
+	for (uint32_t b = 0; b < (mod == MODULATION_TYPE_SINE ? BENCH_BUFS : 1) && r == 0; b++) r = QueueTxMsg(tmp, msg);
+	if (r != 0) {
+		fl2k_433_destroy(tmp);
+		return r;
+	}
+	uint64_t total_us = 0;
+	for (uint32_t b = 0; b < BENCH_BUFS; b++) {
+		uint64_t us;
+		if (!StubDevice_pull(tmp, &us)) {
+			fl2k_433_destroy(tmp);
+			return FL2K_433_ERROR_INVALID_PARAM;
+		}
+		total_us += us;
+	}
+	fl2k_433_destroy(tmp);
+	return (total_us ? (double)BENCH_BUFS * FL2K_BUF_LEN * 1000000.0 / (double)total_us : 0.0);
+}
+
+// Measures the speed of the callback for one kernel (OOK, FSK or SINE) and for the per-sample reference loop it replaced, with
+// fixed settings (BENCH_*): the PRBS7 test message (long enough to keep the kernel busy for all buffers) or a continuous carrier.
+// BENCH_RUNS runs each, kernel and reference alternating. Returns 0 on success
+FL2K_433_API int BenchSynthesis(int mod, int verbose, BenchReport *rep) {
+	if (!rep) {
+		fl2k433_fprintf(stderr, "BenchSynthesis: mandatory parameter is not set.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	if (mod != MODULATION_TYPE_SINE && mod != MODULATION_TYPE_OOK && mod != MODULATION_TYPE_FSK) {
+		fl2k433_fprintf(stderr, "BenchSynthesis: unsupported modulation type.\n");
+		return FL2K_433_ERROR_INVALID_PARAM;
+	}
+	memset(rep, 0, sizeof(BenchReport));
+	rep->mod = mod;
+	rep->n_samples = (uint64_t)BENCH_BUFS * FL2K_BUF_LEN;
+
+	TxMsg msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.mod = mod;
+	if (mod != MODULATION_TYPE_SINE) {
+		uint32_t n_symbols = (uint32_t)(rep->n_samples * VERIFY_IN_RATE / BENCH_SAMP_RATE) / VERIFY_SYMBOL_LEN + 1;
+		msg.len = n_symbols * VERIFY_SYMBOL_LEN;
+		msg.samp_rate = VERIFY_IN_RATE;
+		msg.buf = (char*)malloc(msg.len);
+		if (!msg.buf) {
+			fl2k433_fprintf(stderr, "BenchSynthesis: out of memory\n");
+			return FL2K_433_ERROR_OUTOFMEM;
+		}
+		MakeTestSignal(msg.buf, n_symbols);
+	}
+
+	double sum[2] = { 0.0, 0.0 }, best[2] = { 0.0, 0.0 };
+	int r = 0;
+	for (uint32_t a = 0; a < 2 * BENCH_RUNS && r == 0; a++) {
+		int ref = (a & 1);
+		double speed = BenchRun(mod, &msg, ref);
+		if (speed < 0.0) r = (int)speed;
+		if (speed > best[ref]) best[ref] = speed;
+		sum[ref] += speed;
+	}
+	if (msg.buf) free(msg.buf);
+	if (r != 0) {
+		fl2k433_fprintf(stderr, "BenchSynthesis: test signal could not be rendered (%d).\n", r);
+		return r;
+	}
+	rep->samples_per_sec = best[0];
+	rep->samples_per_sec_mean = sum[0] / BENCH_RUNS;
+	rep->ref_samples_per_sec = best[1];
+	rep->ref_samples_per_sec_mean = sum[1] / BENCH_RUNS;
+	rep->speedup = (best[1] > 0.0 ? best[0] / best[1] : 0.0);
+	rep->realtime = rep->samples_per_sec / BENCH_SAMP_RATE;
+	if (verbose > 0) {
+		const char *names[] = { "NONE", "OOK", "FSK", "SINE" };
+		fl2k433_fprintf(stdout, "BenchSynthesis: %s at %.1f MS/s, best (mean) of %lu runs: kernel %.1f (%.1f) MS/s, reference %.1f (%.1f) MS/s, speedup %.2fx, %.2fx realtime\n",
+			names[mod], BENCH_SAMP_RATE / 1000000.0, (uint32_t)BENCH_RUNS, rep->samples_per_sec / 1000000.0, rep->samples_per_sec_mean / 1000000.0,
+			rep->ref_samples_per_sec / 1000000.0, rep->ref_samples_per_sec_mean / 1000000.0, rep->speedup, rep->realtime);
+	}
+	return 0;
+}
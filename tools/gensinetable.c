@@ -0,0 +1,56 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+ *                           librtl_433                            *
+ *                                                                 *
+ *    A library to facilitate the use of osmo-fl2k for OOK-based   *
+ *    RF transmissions                                             *
+ *                                                                 *
+ *    coded in 2018/19 by winterrace (github.com/winterrace)       *
+ *                                   (github.com/winterrace2)      *
+ *                                                                 *
+ * This program is free software; you can redistribute it and/or   *
+ * modify it under the terms of the GNU General Public License as  *
+ * published by the Free Software Foundation; either version 2 of  *
+ * the License, or (at your option) any later version.             *
+ * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Generates src/sinetable.c (the quarter wave used by SineGen_lookup). Rerun it whenever REFSINE_RESOLUTION changes:
+//   gcc -I../include -o gensinetable gensinetable.c -lm && ./gensinetable > ../src/sinetable.c
+
+#include <stdio.h>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include "sinegen.h"
+
+static const char *banner =
+	"/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *\n"
+	" *                           librtl_433                            *\n"
+	" *                                                                 *\n"
+	" *    A library to facilitate the use of osmo-fl2k for OOK-based   *\n"
+	" *    RF transmissions                                             *\n"
+	" *                                                                 *\n"
+	" *    coded in 2018/19 by winterrace (github.com/winterrace)       *\n"
+	" *                                   (github.com/winterrace2)      *\n"
+	" *                                                                 *\n"
+	" * This program is free software; you can redistribute it and/or   *\n"
+	" * modify it under the terms of the GNU General Public License as  *\n"
+	" * published by the Free Software Foundation; either version 2 of  *\n"
+	" * the License, or (at your option) any later version.             *\n"
+	" * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */\n";
+
+int main(void) {
+	printf("%s\n", banner);
+	printf("// Generated by tools/gensinetable.c, do not edit.\n\n");
+	printf("#include \"sinegen.h\"\n\n");
+	printf("// Quarter wave of the reference sine: sine_quarter[a] = (char)(127.0 * sin(2 * M_PI * a / REFSINE_RESOLUTION)) for a = 0..REFSINE_QUARTER.\n");
+	printf("// The remaining quarters are derived by symmetry (see SineGen_lookup). Generated offline, so no instance has to compute or store its own copy.\n");
+	printf("const signed char sine_quarter[REFSINE_QUARTER + 1] = {\n");
+	for (int a = 0; a <= REFSINE_QUARTER; a++) {
+		if (a % 16 == 0) printf("\t");
+		printf("%d,", (char)(127.0 * sin(2 * M_PI * a / REFSINE_RESOLUTION)));
+		printf((a % 16 == 15 || a == REFSINE_QUARTER) ? "\n" : " ");
+	}
+	printf("};\n");
+	return 0;
+}